@@ -0,0 +1,137 @@
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdalign.h>
+#include <stdbool.h>
+
+#include "arena.h"
+
+// Slabs larger than this are only made for single large allocations.
+#define ARENA_MAX_SLAB_SIZE ((size_t) 16 << 20)
+
+struct Slab {
+    struct Slab *next;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+};
+
+struct ArenaBlock {
+    struct ArenaBlock *next;
+};
+
+static size_t arena_align(size_t size) {
+    size_t align = alignof(max_align_t);
+    return (size + align - 1) & ~(align - 1);
+}
+
+/**
+ * Gets the free list of blocks of an aligned size. Large blocks are filed
+ * under the power of two below their size, and taken from the one above
+ * the size wanted, so every block on a list is large enough.
+ * round_up - true when allocating, false when freeing.
+ */
+static int arena_class(size_t size, bool round_up) {
+    size_t units = size / alignof(max_align_t);
+    if (units <= ARENA_SMALL_CLASSES) {
+        return (int) units - 1;
+    }
+
+    int log = 0;
+    while (((size_t) 1 << (log + 1)) <= units) {
+        log++;
+    }
+    if (round_up && ((size_t) 1 << log) < units) {
+        log++;
+    }
+    // Above the small classes log is at least 5.
+    return ARENA_SMALL_CLASSES + log - 5;
+}
+
+struct Arena *arena_create(size_t slab_size) {
+    struct Arena *a = malloc(sizeof(*a));
+    if (a == NULL) {
+        return NULL;
+    }
+
+    a->slabs = NULL;
+    a->slab_size = slab_size > 0 ? arena_align(slab_size) : 4096;
+    a->bytes = sizeof(*a);
+    for (int i = 0; i < ARENA_FREE_CLASSES; i++) {
+        a->free_lists[i] = NULL;
+    }
+
+    return a;
+}
+
+/**
+ * Allocates size bytes from a free list, or else from the current slab,
+ * starting a new slab when the current one is full.
+ * return - the allocated memory; NULL if memory could not be allocated.
+ */
+void *arena_alloc(struct Arena *a, size_t size) {
+    size = arena_align(size);
+
+    if (size > 0) {
+        struct ArenaBlock **list = &a->free_lists[arena_class(size, true)];
+        if (*list != NULL) {
+            struct ArenaBlock *b = *list;
+            *list = b->next;
+            return b;
+        }
+    }
+
+    struct Slab *s = a->slabs;
+    if (s == NULL || s->size - s->used < size) {
+        size_t slab_size = a->slab_size;
+        if (slab_size < size) {
+            slab_size = size;
+        }
+
+        s = malloc(sizeof(*s) + slab_size);
+        if (s == NULL) {
+            return NULL;
+        }
+        s->size = slab_size;
+        s->used = 0;
+        s->next = a->slabs;
+        a->slabs = s;
+        a->bytes += sizeof(*s) + slab_size;
+
+        if (a->slab_size < ARENA_MAX_SLAB_SIZE) {
+            a->slab_size *= 2;
+        }
+    }
+
+    void *p = (char *) s->data + s->used;
+    s->used += size;
+
+    return p;
+}
+
+void arena_free(struct Arena *a, void *p, size_t size) {
+    // Blocks are at least one alignment unit, which holds the link.
+    size = arena_align(size);
+    if (p == NULL || size == 0) {
+        return;
+    }
+
+    struct ArenaBlock *b = p;
+    struct ArenaBlock **list = &a->free_lists[arena_class(size, false)];
+    b->next = *list;
+    *list = b;
+}
+
+size_t arena_bytes(struct Arena *a) {
+    return a->bytes;
+}
+
+void arena_destroy(struct Arena *a) {
+    struct Slab *s = a->slabs;
+    while (s != NULL) {
+        struct Slab *next = s->next;
+        free(s);
+        s = next;
+    }
+
+    free(a);
+}
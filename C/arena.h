@@ -0,0 +1,56 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+/*
+ * A bump allocator handing out memory from large slabs. Memory is returned
+ * to the system all at once by arena_destroy(), but blocks given back with
+ * arena_free() are kept on free lists by size and handed out again.
+ */
+
+// Freed blocks of up to this many alignment units are kept by exact size,
+// larger ones by the power of two below their size.
+#define ARENA_SMALL_CLASSES 32
+#define ARENA_FREE_CLASSES (ARENA_SMALL_CLASSES + 64)
+
+struct Slab;
+struct ArenaBlock;
+
+struct Arena {
+    struct Slab *slabs;
+    size_t slab_size;
+    size_t bytes;
+    struct ArenaBlock *free_lists[ARENA_FREE_CLASSES];
+};
+
+/**
+ * Creates a new empty arena.
+ * slab_size - size of the first slab in bytes. Later slabs double in size.
+ * return - the new arena; NULL if memory could not be allocated.
+ */
+struct Arena *arena_create(size_t slab_size);
+
+/**
+ * Allocates size bytes from the arena, suitably aligned for any type.
+ * return - the allocated memory; NULL if memory could not be allocated.
+ */
+void *arena_alloc(struct Arena *a, size_t size);
+
+/**
+ * Gives a block back to the arena, to be reused by a later allocation.
+ * size - the size the block was allocated with, or any smaller size.
+ */
+void arena_free(struct Arena *a, void *p, size_t size);
+
+/**
+ * Gets the number of bytes allocated from the system by the arena.
+ */
+size_t arena_bytes(struct Arena *a);
+
+/**
+ * Frees the arena and all memory allocated from it.
+ */
+void arena_destroy(struct Arena *a);
+
+#endif
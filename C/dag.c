@@ -1,84 +1,138 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
 
-#include "queue.h"
+#include "arena.h"
 #include "list.h"
 #include "dag.h"
-
-struct Vertex {
-    int id;
-    int in_count;
-    void *weight;
-};
-
-struct Edge {
-    struct Vertex *from;
-    struct Vertex *to;
-    void *weight;
-};
-
-struct Dag {
-    add_weight_func add;
-    weight_comp_func comp;
-    struct list *v_list;
-    struct list *e_list;
-    int id;
-};
-
-static struct list *dag_get_edges_from(struct Dag *d, struct Vertex *a);
-static struct Dag *dag_clone(struct Dag *d);
+#include "dag_internal.h"
+
+static int dag_edge_array_reserve(struct Dag *d, struct Edge ***arr, 
+                                  int size, int *cap, int extra);
+static int dag_edges_reserve(struct Dag *d, int extra);
+static void dag_link_edge(struct Dag *d, struct Edge *e, struct Vertex *a,
+                          struct Vertex *b, void *w);
+static struct Vertex **dag_reachable_topo_order(struct Dag *d, struct Vertex *a,
+                                                int *n);
+static void *dag_add_and_free(struct Dag *d, void *w, void *x);
+static int dag_vertex_array_push(struct Vertex ***arr, int *size, int *cap,
+                                 struct Vertex *v);
+static void dag_next_mark_epoch(struct Dag *d);
+static int dag_pk_search(struct Dag *d, struct Vertex *start, bool forward,
+                         int bound, struct Vertex *target,
+                         struct Vertex ***found, int *size, int *cap);
+static int dag_pk_reorder(struct Dag *d, struct Vertex *a, struct Vertex *b);
+static int dag_search_reserve(struct Dag *d);
+static int dag_reach_index_query(struct Dag *d, struct Vertex *a, 
+                                 struct Vertex *b);
+static int dag_edge_table_reserve(struct Dag *d, size_t extra);
+static void dag_edge_table_insert(struct Dag *d, struct Edge *e);
+static inline size_t dag_edge_hash(int from, int to);
 
 /**
  * Creates a new dag.
  * return - the new dag on success; null on error.
  */
 struct Dag *dag_create(add_weight_func add_func, weight_comp_func comp_func) {
-    struct Dag *d = malloc(sizeof(*d));
-    d->add = add_func;
-    d->comp = comp_func;
+    return dag_create_with_alloc(add_func, comp_func, ALLOC_MALLOC);
+}
 
+/**
+ * Creates a new dag, allocating its vertices and edges as given by mode.
+ * return - the new dag on success; null on error.
+ */
+struct Dag *dag_create_with_alloc(add_weight_func add_func, 
+                                  weight_comp_func comp_func,
+                                  enum AllocMode mode) {
+    struct Dag *d = malloc(sizeof(*d));
     if (!d) {
         return NULL;
     }
 
-    d->v_list = list_create();
-    d->e_list = list_create();
+    d->add = add_func;
+    d->comp = comp_func;
+    d->arena = NULL;
 
-    if (!d->v_list || !d->e_list) {
-        free(d);
-        return NULL;
+    if (mode == ALLOC_ARENA) {
+        d->arena = arena_create(64 * 1024);
+        if (!d->arena) {
+            free(d);
+            return NULL;
+        }
     }
 
+    d->vertices = NULL;
+    d->v_cap = 0;
+    d->edges = NULL;
+    d->e_size = 0;
+    d->e_cap = 0;
     d->id = 0;
+    d->n_removed = 0;
+    d->mark_epoch = 0;
+    d->seen[0] = d->seen[1] = NULL;
+    d->frontier[0] = d->frontier[1] = NULL;
+    d->search_cap = 0;
+    d->version = 0;
+    d->reach = NULL;
+    d->topo_order = NULL;
+    d->topo_order_cap = 0;
+    d->topo_order_version = 0;
+    d->edge_table = NULL;
+    d->edge_table_cap = 0;
+    d->edge_table_size = 0;
+    d->duplicates = DUPLICATES_ALLOW;
+#ifdef DAG_STATS
+    memset(&d->stats, 0, sizeof(d->stats));
+#endif
 
     return d;
 }
 
 /**
- * Creates a deep clone of the given dag.
- * d - dag to clone
- * return - a clone of d, must be manually freed later.
+ * Allocates memory for a vertex, an edge or an adjacency array, from the
+ * arena if the dag has one.
+ * return - the allocated memory; null on failure.
  */
-struct Dag *dag_clone(struct Dag *d) {
-    struct Dag *clone = dag_create(d->add, d->comp);
-    clone->id = d->id;
-
-    node *v_it = list_first(d->v_list);
-    while(v_it != NULL) {
-        list_insert_after(clone->v_list, NULL, v_it->value);
+static void *dag_alloc(struct Dag *d, size_t size) {
+    DAG_STAT_ADD(d, allocations, 1);
+    DAG_STAT_ADD(d, bytes_live, size);
+    return d->arena ? arena_alloc(d->arena, size) : malloc(size);
+}
 
-        v_it = list_next(v_it);
+/**
+ * Frees size bytes from dag_alloc(). Arena memory is kept by the arena for
+ * later allocations, and only released by dag_destroy().
+ */
+static void dag_free(struct Dag *d, void *p, size_t size) {
+    DAG_STAT_ADD(d, bytes_live, -size);
+    if (d->arena) {
+        arena_free(d->arena, p, size);
+    } else {
+        free(p);
     }
+}
 
-    node *e_it = list_first(d->e_list);
-    while (e_it != NULL) {
-        list_insert_after(clone->e_list, NULL, e_it->value);
-
-        e_it = list_next(e_it);
+/**
+ * Resizes memory from dag_alloc(). In an arena the contents are copied to a
+ * new allocation, and the old one is given back to the arena.
+ * return - the resized memory; null on failure, leaving p untouched.
+ */
+static void *dag_realloc(struct Dag *d, void *p, size_t old_size, 
+                         size_t new_size) {
+    DAG_STAT_ADD(d, allocations, 1);
+    DAG_STAT_ADD(d, bytes_live, new_size - old_size);
+    if (!d->arena) {
+        return realloc(p, new_size);
     }
 
-    return clone;
+    void *res = arena_alloc(d->arena, new_size);
+    if (res && p) {
+        memcpy(res, p, old_size < new_size ? old_size : new_size);
+        arena_free(d->arena, p, old_size);
+    }
+    return res;
 }
 
 /**
@@ -88,21 +142,37 @@ struct Dag *dag_clone(struct Dag *d) {
  * return - the created vertex on success; null if an error occurs.
  */
 struct Vertex *dag_add_vertex(struct Dag *d, void *w) {
-    struct Vertex *v = malloc(sizeof(*v));
-    if (v == NULL) {
-        return NULL;
+    DAG_STAT_CALL(d, DAG_API_ADD_VERTEX);
+    if (d->id == d->v_cap) {
+        int new_cap = d->v_cap == 0 ? 16 : d->v_cap * 2;
+        struct Vertex **tmp = realloc(d->vertices, new_cap * sizeof(*tmp));
+        if (tmp == NULL) {
+            return NULL;
+        }
+        d->vertices = tmp;
+        d->v_cap = new_cap;
     }
 
-    node *res = list_insert_after(d->v_list, NULL, v);
-    if (res == NULL) {
-        free(v);
+    struct Vertex *v = dag_alloc(d, sizeof(*v));
+    if (v == NULL) {
         return NULL;
     }
 
-    res->value = v;
+    d->vertices[d->id] = v;
     v->id = d->id++;
     v->weight = w;
-    v->in_count = 0;
+    v->out = NULL;
+    v->out_size = 0;
+    v->out_cap = 0;
+    v->in = NULL;
+    v->in_size = 0;
+    v->in_cap = 0;
+    // A vertex without edges can go last in the current order.
+    v->topo_rank = v->id;
+    v->mark = 0;
+    v->removed = false;
+
+    d->version++;
 
     return v;
 }
@@ -117,375 +187,2119 @@ struct Vertex *dag_add_vertex(struct Dag *d, void *w) {
  * return - 0 if the edge was inserted successfully, -1 otherwise.
  */
 int dag_add_edge(struct Dag *d, struct Vertex *a, struct Vertex *b, void *w) {
-    // This would lead to a cycle, which is not allowed in a DAG!
-    if (dag_is_connected(d, b, a) == 1) {
+    DAG_STAT_CALL(d, DAG_API_ADD_EDGE);
+    if (a->removed || b->removed) return -1;
+    if (d->duplicates != DUPLICATES_ALLOW && dag_find_edge(d, a, b) != NULL) {
+        return d->duplicates == DUPLICATES_MERGE ? 0 : -1;
+    }
+    // If a is already ordered before b the edge can not close a cycle,
+    // otherwise the affected part of the order must be searched and fixed.
+    if (a->topo_rank >= b->topo_rank && dag_pk_reorder(d, a, b) != 0) {
         return -1;
     }
-    struct Edge *e = malloc(sizeof(*e));
-
-    if (e == NULL) {
+    // Make room for the edge everywhere first, so that it can not be left
+    // half inserted.
+    if (dag_edge_table_reserve(d, 1) < 0 || dag_edges_reserve(d, 1) < 0 
+            || dag_edge_array_reserve(d, &a->out, a->out_size, &a->out_cap, 1) < 0
+            || dag_edge_array_reserve(d, &b->in, b->in_size, &b->in_cap, 1) < 0) {
         return -1;
     }
+    struct Edge *e = dag_alloc(d, sizeof(*e));
 
-    node *res = list_insert_after(d->e_list, NULL, e);
-    if (res == NULL) {
-        free(e);
+    if (e == NULL) {
         return -1;
     }
 
-    res->value = e;
-    e->from = a;
-    e->to = b;
-    e->weight = w;
-
-    b->in_count++;
+    dag_link_edge(d, e, a, b, w);
+    d->version++;
 
     return 0;
 }
 
-/**
- * Gets the weight of the given vertex.
- * returns - the weight of the given vertex.
- */
-void *dag_v_get_weight(struct Vertex *v) {
-    return v->weight;
-}
+static int dag_cmp_edge_pair(const void *x, const void *y) {
+    const int *a = x;
+    const int *b = y;
 
-/**
- * Gets the ID of the given vertex
- * returns - the ID of the given vertex.
- */
-int dag_v_get_id(struct Vertex *v) {
-    return v->id;
+    if (a[0] != b[0]) return (a[0] > b[0]) - (a[0] < b[0]);
+    return (a[1] > b[1]) - (a[1] < b[1]);
 }
 
 /**
- * Searches for an edge between vertex a and vertex b, and returns if it 
- * exists.
- * d - dag containing a and b.
- * a - start vertex.
- * b - destination vertex.
- * 
- * return - the edge from a to b if it exists; null otherwise.
+ * Checks whether any of the given edges duplicates an edge in the graph or
+ * another edge in the batch.
+ * return - 1 if there is a duplicate; 0 if not; -1 on allocation failure.
  */
-struct Edge *dag_find_edge(struct Dag *d, struct Vertex *a, struct Vertex *b) {
-    struct node *n = list_first(d->e_list);
+static int dag_bulk_has_duplicates(struct Dag *d, struct Vertex **from,
+                                   struct Vertex **to, int n) {
+    int *pairs = malloc(2 * (size_t) n * sizeof(*pairs));
+    if (pairs == NULL) {
+        return -1;
+    }
 
-    while (n != NULL) { 
-        struct Edge *e = n->value;
-        if (a->id == e->from->id && b->id == e->to->id) {
-            return e;
+    int res = 0;
+    for (int i = 0; i < n && !res; i++) {
+        if (dag_find_edge(d, from[i], to[i]) != NULL) {
+            res = 1;
         }
+        pairs[2 * i] = from[i]->id;
+        pairs[2 * i + 1] = to[i]->id;
+    }
 
-        n = list_next(n);
+    if (!res) {
+        qsort(pairs, n, 2 * sizeof(*pairs), dag_cmp_edge_pair);
+        for (int i = 1; i < n && !res; i++) {
+            if (pairs[2 * i] == pairs[2 * i - 2] 
+                    && pairs[2 * i + 1] == pairs[2 * i - 1]) {
+                res = 1;
+            }
+        }
     }
 
-    return NULL;
+    free(pairs);
+
+    return res;
 }
 
 /**
- * Gets all edges from the given node. Returns a list that must be manually
- * free later.
- * d - graph containing the vertex a
- * a - vertex to get all edges from.
- * return - a list containing all edges from a; null if there are no such edges.
+ * Finds the strongly connected components of the vertices left over by
+ * Kahn's algorithm, over the old edges and the new ones indexed by start
+ * vertex, with an iterative version of Tarjan's algorithm.
+ * left - non-zero for the vertices to search.
+ * comp - receives the component of each searched vertex.
+ * return - 0 on success; -1 if memory could not be allocated.
  */
-static struct list *dag_get_edges_from(struct Dag *d, struct Vertex *a) {
-    struct list *res = list_create();
-    struct node *e_it = list_first(d->e_list);
+static int dag_bulk_components(struct Dag *d, struct Vertex **to, 
+                               const int *out_start, const int *out_idx, 
+                               const int *left, int *comp) {
+    int v_count = d->id;
+    int *index = malloc(v_count * sizeof(*index));
+    int *low = malloc(v_count * sizeof(*low));
+    int *next = malloc(v_count * sizeof(*next));
+    int *stack = malloc(v_count * sizeof(*stack));
+    int *calls = malloc(v_count * sizeof(*calls));
+    if (!index || !low || !next || !stack || !calls) {
+        free(index);
+        free(low);
+        free(next);
+        free(stack);
+        free(calls);
+        return -1;
+    }
+
+    for (int v = 0; v < v_count; v++) {
+        index[v] = -1;
+        comp[v] = -1;
+    }
+
+    // A vertex is on the stack while it has an index but no component.
+    int counter = 0;
+    int n_comp = 0;
+    int sp = 0;
+    for (int root = 0; root < v_count; root++) {
+        if (!left[root] || index[root] >= 0) continue;
+
+        int cp = 0;
+        index[root] = low[root] = counter++;
+        next[root] = 0;
+        stack[sp++] = root;
+        calls[cp++] = root;
+
+        while (cp > 0) {
+            int v = calls[cp - 1];
+            struct Vertex *u = d->vertices[v];
+            int n_new = out_start[v + 1] - out_start[v];
+
+            if (next[v] < u->out_size + n_new) {
+                int j = next[v]++;
+                int w = j < u->out_size ? u->out[j]->to->id 
+                        : to[out_idx[out_start[v] + j - u->out_size]]->id;
+                if (!left[w]) continue;
+
+                if (index[w] < 0) {
+                    index[w] = low[w] = counter++;
+                    next[w] = 0;
+                    stack[sp++] = w;
+                    calls[cp++] = w;
+                } else if (comp[w] < 0 && index[w] < low[v]) {
+                    low[v] = index[w];
+                }
+                continue;
+            }
 
-    while (e_it != NULL) {
-        struct Edge *e = e_it->value;
-        if (e->from->id == a->id) {
-            list_insert_last(res, e);
+            cp--;
+            if (low[v] == index[v]) {
+                int w;
+                do {
+                    w = stack[--sp];
+                    comp[w] = n_comp;
+                } while (w != v);
+                n_comp++;
+            }
+            if (cp > 0 && low[v] < low[calls[cp - 1]]) {
+                low[calls[cp - 1]] = low[v];
+            }
         }
-        e_it = list_next(e_it);
     }
 
-    return res;
+    free(index);
+    free(low);
+    free(next);
+    free(stack);
+    free(calls);
+
+    return 0;
 }
 
 /**
- * Checks if there is some path between vertex a and vertex b.
- * d - graph containing the vertices
- * a - starting vertex
- * b - destination vertex
- * returns: 1 if connected; 0 if not connected; -1 if an error occurred.
+ * Adds n edges to the graph at once, checking for cycles only once with
+ * Kahn's algorithm over the whole graph, in O(V + E) time. Either all edges
+ * are added or none of them are.
+ * d - dag to insert the edges into
+ * from - start vertices of the edges.
+ * to - destination vertices of the edges.
+ * weights - weights of the edges; may be null to give every edge a null
+ *           weight.
+ * n - number of edges.
+ * cyclic - if not null, an array of n elements receiving the indices of
+ *          the edges that lie on cycles when the edges can not be added.
+ * n_cyclic - if not null, set to the number of indices written to cyclic.
+ * return - 0 if all edges were added; -1 if none were.
  */
-int dag_is_connected(struct Dag *d, struct Vertex *a, struct Vertex *b) {
-    if (!d || !a || !b) return -1;
-
-    struct Queue *q = queue_create();
-    if (q == NULL) {
+int dag_add_edges_bulk(struct Dag *d, struct Vertex **from, struct Vertex **to,
+                       void **weights, int n, int *cyclic, int *n_cyclic) {
+    DAG_STAT_CALL(d, DAG_API_ADD_EDGES_BULK);
+    if (n_cyclic) *n_cyclic = 0;
+    if (!d || n < 0 || (n > 0 && (!from || !to))) return -1;
+    for (int i = 0; i < n; i++) {
+        if (!from[i] || !to[i] || from[i]->removed || to[i]->removed) {
+            return -1;
+        }
+    }
+    if (d->duplicates == DUPLICATES_REJECT 
+            && dag_bulk_has_duplicates(d, from, to, n) != 0) {
         return -1;
     }
 
-    queue_enqueue(q, a);
+    int v_count = d->id;
+    int *out_start = calloc(v_count + 1, sizeof(*out_start));
+    int *in_start = calloc(v_count + 1, sizeof(*in_start));
+    int *cursor = malloc(v_count * sizeof(*cursor));
+    int *out_idx = malloc(n * sizeof(*out_idx));
+    int *indeg = malloc(v_count * sizeof(*indeg));
+    struct Vertex **order = malloc(v_count * sizeof(*order));
+    struct Edge **new_edges = malloc(n * sizeof(*new_edges));
+    int res = 0;
+
+    if (!out_start || !in_start || !cursor || !out_idx || !indeg 
+            || !order || !new_edges) {
+        res = -1;
+        goto cleanup;
+    }
+
+    // Index the new edges by start vertex, as compressed rows, and count
+    // them by end vertex.
+    for (int i = 0; i < n; i++) {
+        out_start[from[i]->id + 1]++;
+        in_start[to[i]->id + 1]++;
+    }
+    for (int v = 0; v < v_count; v++) {
+        out_start[v + 1] += out_start[v];
+        in_start[v + 1] += in_start[v];
+    }
+    for (int v = 0; v < v_count; v++) {
+        cursor[v] = out_start[v];
+    }
+    for (int i = 0; i < n; i++) {
+        out_idx[cursor[from[i]->id]++] = i;
+    }
+
+    // Kahn's algorithm over the old and the new edges together.
+    int head = 0;
+    int tail = 0;
+    for (int v = 0; v < v_count; v++) {
+        indeg[v] = d->vertices[v]->in_size + in_start[v + 1] - in_start[v];
+        if (indeg[v] == 0) {
+            order[tail++] = d->vertices[v];
+        }
+    }
+
+    while (head < tail) {
+        struct Vertex *u = order[head++];
 
-    while(!queue_is_empty(q)) {
-        struct node *next = queue_dequeue(q);
-        struct Vertex *v = next->value;
+        for (int j = 0; j < u->out_size; j++) {
+            struct Vertex *w = u->out[j]->to;
+            if (--indeg[w->id] == 0) order[tail++] = w;
+        }
+        for (int j = out_start[u->id]; j < out_start[u->id + 1]; j++) {
+            struct Vertex *w = to[out_idx[j]];
+            if (--indeg[w->id] == 0) order[tail++] = w;
+        }
+    }
 
-        if (v->id == b->id) {
-            free(next);
-            queue_destroy(q);
-            return 1;
+    if (tail < v_count) {
+        // The vertices with indeg > 0 are on cycles or after them. An edge 
+        // is on a cycle exactly when both its ends are in the same strongly
+        // connected component, and the old graph is acyclic, so every cycle
+        // uses a new edge.
+        int *comp = cursor;
+        res = -1;
+        if ((cyclic || n_cyclic) 
+                && dag_bulk_components(d, to, out_start, out_idx, indeg, 
+                                       comp) == 0) {
+            int count = 0;
+            for (int i = 0; i < n; i++) {
+                if (indeg[from[i]->id] > 0 
+                        && comp[from[i]->id] == comp[to[i]->id]) {
+                    if (cyclic) cyclic[count] = i;
+                    count++;
+                }
+            }
+            if (n_cyclic) *n_cyclic = count;
         }
+        goto cleanup;
+    }
 
-        // Find all nodes we can reach from v
-        struct list *l = d->e_list;
-        struct node *n = list_first(l);
-        while (n != NULL) {
-            struct Edge *e = n->value;
-            if (v->id == e->from->id) {
-                queue_enqueue(q, e->to);
+    // Reserve room for every edge before changing anything.
+    if (dag_edge_table_reserve(d, n) < 0 || dag_edges_reserve(d, n) < 0) {
+        res = -1;
+        goto cleanup;
+    }
+    for (int v = 0; v < v_count && res == 0; v++) {
+        struct Vertex *u = d->vertices[v];
+        if (dag_edge_array_reserve(d, &u->out, u->out_size, &u->out_cap,
+                                   out_start[v + 1] - out_start[v]) < 0
+                || dag_edge_array_reserve(d, &u->in, u->in_size, &u->in_cap,
+                                          in_start[v + 1] - in_start[v]) < 0) {
+            res = -1;
+        }
+    }
+    for (int i = 0; i < n && res == 0; i++) {
+        new_edges[i] = dag_alloc(d, sizeof(**new_edges));
+        if (new_edges[i] == NULL) {
+            for (int j = 0; j < i; j++) {
+                dag_free(d, new_edges[j], sizeof(**new_edges));
             }
+            res = -1;
+        }
+    }
+    if (res < 0) {
+        goto cleanup;
+    }
 
-            n = list_next(n);
+    for (int i = 0; i < n; i++) {
+        if (d->duplicates == DUPLICATES_MERGE 
+                && dag_find_edge(d, from[i], to[i]) != NULL) {
+            dag_free(d, new_edges[i], sizeof(**new_edges));
+            continue;
         }
+        dag_link_edge(d, new_edges[i], from[i], to[i], 
+                      weights ? weights[i] : NULL);
+    }
 
-        free(next);
+    // Kahn's order replaces the order maintained by dag_add_edge().
+    for (int i = 0; i < v_count; i++) {
+        order[i]->topo_rank = i;
     }
+    d->version++;
 
-    queue_destroy(q);
+cleanup:
+    free(out_start);
+    free(in_start);
+    free(cursor);
+    free(out_idx);
+    free(indeg);
+    free(order);
+    free(new_edges);
 
-    return 0;
+    return res;
 }
 
 /**
- * Computes the weight of the longest path between the vertices a and b.
- * d - graph containing the vertices and edges.
- * a - Path start
- * b - Path end
- * f - function for interpreting the weight of the vertices
- * g - function for interpreting the weight of the edges.
- * return - the weight of the longest path between a and b. NULL is returned if 
- * f or g are NULL, or if `add` and `compare` functions are not defined.
+ * Fills in the edge e from a to b and adds it to the adjacency arrays, the
+ * edge array and the edge hash table, which must all have room for it.
  */
-void *dag_weight_of_longest_path(struct Dag *d,
-                                struct Vertex *a, struct Vertex *b,
-                                get_weight_func f, get_weight_func g) {
-    if (!f || !g || !d->add || !d->comp) return NULL;
-    struct list *all_paths = dag_get_all_paths(d, a, b);
-    struct node *n = list_first(all_paths);
+static void dag_link_edge(struct Dag *d, struct Edge *e, struct Vertex *a,
+                          struct Vertex *b, void *w) {
+    e->from = a;
+    e->to = b;
+    e->weight = w;
+    e->index = d->e_size;
+    e->out_pos = a->out_size;
+    e->in_pos = b->in_size;
+
+    a->out[a->out_size++] = e;
+    b->in[b->in_size++] = e;
+    d->edges[d->e_size++] = e;
+    dag_edge_table_insert(d, e);
+}
 
-    void *curr_weight = NULL;
-    void *prev;
+/**
+ * Removes e from the edge hash table, if it is the edge stored for its end
+ * points. The slot is emptied by shifting later entries of the probe 
+ * sequence back, so that lookups never need tombstones.
+ * replace - if true, another edge parallel to e takes over its slot instead.
+ */
+static void dag_edge_table_remove(struct Dag *d, struct Edge *e, 
+                                  bool replace) {
+    if (d->edge_table_size == 0) {
+        return;
+    }
 
-    while (n != NULL) {
-        struct list *path = n->value;
-        struct node *v_it = list_first(path);
-
-        struct Vertex *from = v_it->value;
-        struct Vertex *to = list_next(v_it)->value;
-        struct Edge *e = dag_find_edge(d, from, to);
-
-        void *weight = NULL;
-        weight = d->add(weight, f(from->weight));
-        prev = weight;
-        weight = d->add(weight, g(e->weight));
-        free(prev);
-        
-        v_it = list_next(v_it);
-
-        int i = 1;
-        while (v_it != NULL) {
-            struct Vertex *v = v_it->value;
-            prev = weight;
-            weight = d->add(weight, f(v->weight));
-            free(prev);
-
-            if (i < path->size - 1) {
-                struct Edge *edge = dag_find_edge(d, v, list_next(v_it)->value);
-                prev = weight;
-                weight = d->add(weight, g(edge->weight));
-                free(prev);
+    size_t mask = d->edge_table_cap - 1;
+    size_t i = dag_edge_hash(e->from->id, e->to->id) & mask;
+    while (d->edge_table[i] != NULL && d->edge_table[i] != e) {
+        i = (i + 1) & mask;
+    }
+    if (d->edge_table[i] == NULL) {
+        // A parallel edge is stored instead.
+        return;
+    }
+
+    if (replace) {
+        struct Vertex *a = e->from;
+        for (int j = 0; j < a->out_size; j++) {
+            if (a->out[j] != e && a->out[j]->to == e->to) {
+                d->edge_table[i] = a->out[j];
+                return;
             }
-        
-            v_it = list_next(v_it);
-            i++;
         }
+    }
 
-        if (curr_weight == NULL || d->comp(weight, curr_weight) == GREATER_THAN) {
-            if (curr_weight) free(curr_weight);
-            curr_weight = weight;
-        } else {
-            free(weight);
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        struct Edge *other = d->edge_table[j];
+        if (other == NULL) {
+            break;
+        }
+        // The entry can fill the hole unless its home slot lies cyclically
+        // after the hole, up to where it is.
+        size_t home = dag_edge_hash(other->from->id, other->to->id) & mask;
+        bool stays = i <= j ? (i < home && home <= j) 
+                            : (i < home || home <= j);
+        if (!stays) {
+            d->edge_table[i] = other;
+            i = j;
         }
-        
-        n = list_next(n);
     }
+    d->edge_table[i] = NULL;
+    d->edge_table_size--;
+}
 
+/**
+ * Removes an edge from an adjacency array by moving the last edge into its
+ * place, and halves arrays that have become less than a quarter full.
+ * pos - the position of the edge, which is updated for the moved edge.
+ */
+static void dag_edge_array_remove(struct Dag *d, struct Edge ***arr, 
+                                  int *size, int *cap, int pos, bool out) {
+    struct Edge *last = (*arr)[--*size];
+    (*arr)[pos] = last;
+    if (out) {
+        last->out_pos = pos;
+    } else {
+        last->in_pos = pos;
+    }
 
-    dag_all_paths_list_destroy(all_paths);
-
-    return curr_weight;
+    if (*cap > 4 && *size <= *cap / 4) {
+        struct Edge **tmp = dag_realloc(d, *arr, *cap * sizeof(*tmp),
+                                        *cap / 2 * sizeof(*tmp));
+        if (tmp != NULL) {
+            *arr = tmp;
+            *cap /= 2;
+        }
+    }
 }
 
 /**
- * Performs a topological ordering, using Kahn's algorithm.
- * dag - graph containing the vertices to sort.
- * return - A list containing the sorted elements. This list must be 
- *          freed by calling dag_destroy_path() to avoid memory leaks.
+ * Unlinks e from everything dag_link_edge() added it to, and frees it. The
+ * version of the graph is left to the caller.
+ * replace - passed on to dag_edge_table_remove().
  */
-struct list *dag_topological_ordering(struct Dag *d) {
-    struct Dag *graph = dag_clone(d);
+void dag_unlink_edge(struct Dag *d, struct Edge *e, bool replace, 
+                     bool free_weight) {
+    struct Vertex *a = e->from;
+    struct Vertex *b = e->to;
+
+    dag_edge_table_remove(d, e, replace);
+    dag_edge_array_remove(d, &a->out, &a->out_size, &a->out_cap, e->out_pos,
+                          true);
+    dag_edge_array_remove(d, &b->in, &b->in_size, &b->in_cap, e->in_pos,
+                          false);
+
+    struct Edge *last = d->edges[--d->e_size];
+    d->edges[e->index] = last;
+    last->index = e->index;
+
+    if (free_weight) {
+        free(e->weight);
+    }
+    dag_free(d, e, sizeof(*e));
+}
 
-    struct list *sorted_list = list_create();
-    struct list *no_incoming_edges = list_create();
+/**
+ * Removes the edge between vertex a and vertex b, in time proportional to 
+ * the out-degree of a.
+ * d - dag containing the edge.
+ * a - start vertex.
+ * b - destination vertex.
+ * free_weight - if true, the weight of the edge is freed.
+ * return - 0 if the edge was removed; -1 if there is no such edge.
+ */
+int dag_remove_edge(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                    bool free_weight) {
+    DAG_STAT_CALL(d, DAG_API_REMOVE_EDGE);
+    if (!d || !a || !b) return -1;
 
-    // Store all vertices with no incoming edges in the given list.
-    struct node *n = list_first(graph->v_list);
-    while (n != NULL) {
-        struct Vertex *v = n->value;
-        if (v->in_count == 0) {
-            list_insert_after(no_incoming_edges, NULL, v);
-        }
-        n = list_next(n);
+    struct Edge *e = dag_find_edge(d, a, b);
+    if (e == NULL) {
+        return -1;
     }
 
-    while(no_incoming_edges->size > 0 && list_first(no_incoming_edges)) {
-        struct Vertex *f_node = list_first(no_incoming_edges)->value;
-        list_insert_last(sorted_list, f_node);
-        list_remove_after(no_incoming_edges, NULL);        
+    // Removing an edge keeps the topological order valid.
+    dag_unlink_edge(d, e, true, free_weight);
+    d->version++;
+
+    return 0;
+}
+
+/**
+ * Removes a vertex and its edges, leaving a tombstone so that other ids do
+ * not change. The tombstone keeps its rank in the topological order, which
+ * stays valid, and its id until dag_compact().
+ * d - dag containing the vertex.
+ * v - vertex to remove.
+ * free_weight - if true, the weights of the vertex and its edges are freed.
+ * return - 0 if the vertex was removed; -1 if it already was.
+ */
+int dag_remove_vertex(struct Dag *d, struct Vertex *v, bool free_weight) {
+    DAG_STAT_CALL(d, DAG_API_REMOVE_VERTEX);
+    if (!d || !v || v->removed) return -1;
+
+    // Every edge parallel to a removed one goes too, so no slot of the edge
+    // table is handed over.
+    while (v->out_size > 0) {
+        dag_unlink_edge(d, v->out[v->out_size - 1], false, free_weight);
+    }
+    while (v->in_size > 0) {
+        dag_unlink_edge(d, v->in[v->in_size - 1], false, free_weight);
+    }
+    dag_free(d, v->out, v->out_cap * sizeof(*v->out));
+    dag_free(d, v->in, v->in_cap * sizeof(*v->in));
+    v->out = v->in = NULL;
+    v->out_cap = v->in_cap = 0;
 
-        struct list *edges = dag_get_edges_from(graph, f_node);
-        if (edges->size > 0) {
-            // Loop through all edges that have an edge from `node`
-            struct node *iterator = list_first(edges);
-            while (iterator != NULL) {
-                struct Edge *edge = iterator->value;
-                edge->to->in_count--;
+    if (free_weight) {
+        free(v->weight);
+    }
+    v->weight = NULL;
+    v->removed = true;
+    d->n_removed++;
+    d->version++;
 
-                list_remove_after(edges, NULL);
+    return 0;
+}
 
-                if (edge->to->in_count == 0) {
-                    list_insert_last(no_incoming_edges, edge->to);
-                }
+/**
+ * Frees the tombstones left by dag_remove_vertex(), and numbers the other
+ * vertices from 0 in the order of their old ids. The topological ranks are
+ * closed up the same way, and the edge hash table, which is keyed on ids,
+ * is rebuilt with the same capacity. Runs in O(V + E) time.
+ * d - dag to compact.
+ * n - if not null, receives the number of entries in the returned array.
+ * return - an array mapping each old id to the new id, or to -1 for removed
+ *          vertices, to be freed with free(); null if an error occurred, 
+ *          leaving the graph unchanged.
+ */
+int *dag_compact(struct Dag *d, int *n) {
+    DAG_STAT_CALL(d, DAG_API_COMPACT);
+    if (n) *n = 0;
+    if (!d) return NULL;
+
+    // Allocate everything first, so that the graph is either compacted
+    // completely or not at all.
+    int old_count = d->id;
+    int *map = malloc((old_count + 1) * sizeof(*map));
+    struct Vertex **by_rank = malloc((old_count + 1) * sizeof(*by_rank));
+    struct Edge **table = d->edge_table_cap == 0 ? NULL 
+                          : calloc(d->edge_table_cap, sizeof(*table));
+    if (!map || !by_rank || (d->edge_table_cap > 0 && !table)) {
+        free(map);
+        free(by_rank);
+        free(table);
+        return NULL;
+    }
 
-                iterator = list_first(edges);
-            }
+    // Ranks are a permutation of all ids, tombstones included.
+    for (int i = 0; i < old_count; i++) {
+        by_rank[d->vertices[i]->topo_rank] = d->vertices[i];
+    }
+    int rank = 0;
+    for (int i = 0; i < old_count; i++) {
+        if (!by_rank[i]->removed) {
+            by_rank[i]->topo_rank = rank++;
         }
+    }
 
-        struct node *e = list_first(edges);
-        while (e != NULL) {
-            list_remove_after(edges, list_first(edges));
-            e = list_first(edges);
+    int count = 0;
+    for (int i = 0; i < old_count; i++) {
+        struct Vertex *v = d->vertices[i];
+        if (v->removed) {
+            map[i] = -1;
+            dag_free(d, v, sizeof(*v));
+            continue;
         }
-        list_destroy(edges);
+        map[i] = count;
+        v->id = count;
+        d->vertices[count++] = v;
     }
+    d->id = count;
+    d->n_removed = 0;
+
+    // Only the edge found by dag_find_edge() is in the table for each pair
+    // of vertices, so moving those over keeps the same edges findable.
+    struct Edge **old_table = d->edge_table;
+    size_t old_cap = d->edge_table_cap;
+    d->edge_table = table;
+    d->edge_table_size = 0;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old_table[i] != NULL) {
+            dag_edge_table_insert(d, old_table[i]);
+        }
+    }
+    free(old_table);
 
-    list_destroy(no_incoming_edges);
-    
-    while (list_first(graph->e_list)) {
-        list_remove_after(graph->e_list, NULL);
-    } 
-    while (list_first(graph->v_list)) {
-        list_remove_after(graph->v_list, NULL);
+    struct Vertex **tmp = realloc(d->vertices, 
+                                  (count > 0 ? count : 1) * sizeof(*tmp));
+    if (tmp != NULL) {
+        d->vertices = tmp;
+        d->v_cap = count > 0 ? count : 1;
     }
-    list_destroy(graph->e_list);
-    list_destroy(graph->v_list);
-    free(graph);
 
-    return sorted_list;
+    free(by_rank);
+    d->version++;
+
+    if (n) *n = old_count;
+    return map;
 }
 
 /**
- * Traverses the graph and creates a list of paths between the vertices 
- * that is then returned.
- * d - dag containing the vertices a and b.
- * a - Starting vertex
- * b - Goal vertex
- * return - The path between a and b. This list must be destroy with
- *          dag_all_paths_list_destroy()
+ * Makes sure a growable edge array has room for extra more edges, doubling
+ * its capacity until they fit.
+ * d - dag that allocates the array.
+ * arr - the array to grow.
+ * size - number of edges currently stored in the array.
+ * cap - capacity of the array.
+ * extra - number of edges that will be appended.
+ * return - 0 on success; -1 if the array could not be grown.
  */
-struct list *dag_get_all_paths(struct Dag *d, struct Vertex *a, struct Vertex *b) {
-    struct list *all_paths = list_create();
+static int dag_edge_array_reserve(struct Dag *d, struct Edge ***arr, 
+                                  int size, int *cap, int extra) {
+    if (size + extra <= *cap) {
+        return 0;
+    }
 
-    struct Queue *queue = queue_create();
-    struct list *first_path = list_create();
+    int new_cap = *cap == 0 ? 4 : *cap * 2;
+    while (new_cap < size + extra) {
+        new_cap *= 2;
+    }
 
-    list_insert_after(first_path, NULL, a);
-    queue_enqueue(queue, first_path);
+    struct Edge **tmp = dag_realloc(d, *arr, *cap * sizeof(*tmp),
+                                    new_cap * sizeof(*tmp));
+    if (tmp == NULL) {
+        return -1;
+    }
+    *arr = tmp;
+    *cap = new_cap;
 
-    while(!queue_is_empty(queue)) {
-        struct node *p = queue_dequeue(queue);
-        struct list *path = p->value;
-        struct Vertex *next = list_get_last(path)->value;
+    return 0;
+}
 
-        free(p);
+/**
+ * Makes sure the dags edge array has room for extra more edges.
+ * return - 0 on success; -1 if the array could not be grown.
+ */
+static int dag_edges_reserve(struct Dag *d, int extra) {
+    if (d->e_size + extra <= d->e_cap) {
+        return 0;
+    }
 
-        int has_path = 0;
-        if (next->id == b->id) {
-            // The end of a path
-            has_path = 1;
-            list_insert_last(all_paths, path);
-        }
-
-        // Find all nodes we can reach from `next`
-        struct list *l = d->e_list;
-        struct node *n = list_first(l);
-        while (n != NULL) {
-            struct Edge *e = n->value;
-            if (next->id == e->from->id) {
-                // create new path
-                struct list *new_path = list_create();
-                // copy path to new_path
-                struct node *it = list_first(path);
-                while (it != NULL) {
-                    list_insert_last(new_path, it->value);
-
-                    it = list_next(it);
-                }
+    int new_cap = d->e_cap == 0 ? 16 : d->e_cap * 2;
+    while (new_cap < d->e_size + extra) {
+        new_cap *= 2;
+    }
 
-                list_insert_last(new_path, e->to);
-                queue_enqueue(queue, new_path);
-            }
+    struct Edge **tmp = realloc(d->edges, new_cap * sizeof(*tmp));
+    if (tmp == NULL) {
+        return -1;
+    }
+    d->edges = tmp;
+    d->e_cap = new_cap;
 
-            n = list_next(n);
-        }
+    return 0;
+}
 
-        // This implies that the current path is a dead end
-        if (has_path == 0) {
-            dag_destroy_path(path);
+/**
+ * Appends v to a growable vertex array, doubling its capacity when full.
+ * return - 0 on success; -1 if the array could not be grown.
+ */
+static int dag_vertex_array_push(struct Vertex ***arr, int *size, int *cap,
+                                 struct Vertex *v) {
+    if (*size == *cap) {
+        int new_cap = *cap == 0 ? 16 : *cap * 2;
+        struct Vertex **tmp = realloc(*arr, new_cap * sizeof(*tmp));
+        if (tmp == NULL) {
+            return -1;
         }
+        *arr = tmp;
+        *cap = new_cap;
     }
 
-    queue_destroy(queue);
+    (*arr)[(*size)++] = v;
 
-    return all_paths;
+    return 0;
 }
 
 /**
- * Cleans up dynamically allocated resources. This will destroy the graph,
- * vertices and edges.
- * d - cleans up the resources used by the dag.
- * free_weight - if set to true, this function will free the weights used
- *               by the vertices and edges. Must be set to false if the weights
- *               are not dynamically allocated.
+ * Starts a new search by advancing the mark epoch, so that no vertex is 
+ * considered visited. The marks are cleared if the epoch wraps around.
  */
-int dag_destroy(struct Dag *d, bool free_weight) {
-    while (list_first(d->v_list)) {
-        struct Vertex *v = list_first(d->v_list)->value;
-        if (free_weight)
-            free(v->weight);
-        free(v);
+static void dag_next_mark_epoch(struct Dag *d) {
+    d->mark_epoch++;
+    if (d->mark_epoch == 0) {
+        for (int i = 0; i < d->id; i++) {
+            d->vertices[i]->mark = 0;
+        }
+        d->mark_epoch = 1;
+    }
+}
+
+/**
+ * Searches the region of the graph affected by a new edge, for the
+ * Pearce-Kelly reordering. The forward search follows outgoing edges to
+ * vertices ranked below bound, the backward search follows incoming edges
+ * to vertices ranked above bound.
+ * d - graph to search.
+ * start - vertex to start from.
+ * forward - true to search forwards; false to search backwards.
+ * bound - rank limit of the search.
+ * target - vertex whose discovery means the new edge closes a cycle.
+ * found - array receiving the visited vertices, start included.
+ * return - 1 if target was found; 0 if not; -1 on allocation failure.
+ */
+static int dag_pk_search(struct Dag *d, struct Vertex *start, bool forward,
+                         int bound, struct Vertex *target,
+                         struct Vertex ***found, int *size, int *cap) {
+    dag_next_mark_epoch(d);
 
-        list_remove_after(d->v_list, NULL);
+    start->mark = d->mark_epoch;
+    if (dag_vertex_array_push(found, size, cap, start) < 0) {
+        return -1;
     }
 
-    while (list_first(d->e_list)) {
-        struct Edge *e = list_first(d->e_list)->value;
-        if (free_weight) {
-            free(e->weight);
+    // The found array doubles as the work list of the search.
+    for (int i = 0; i < *size; i++) {
+        struct Vertex *v = (*found)[i];
+        int degree = forward ? v->out_size : v->in_size;
+        DAG_STAT_ADD(d, vertices_visited, 1);
+        DAG_STAT_ADD(d, edges_scanned, degree);
+
+        for (int j = 0; j < degree; j++) {
+            struct Vertex *w = forward ? v->out[j]->to : v->in[j]->from;
+
+            if (w == target) {
+                return 1;
+            }
+            if (w->mark == d->mark_epoch) {
+                continue;
+            }
+            if (forward ? w->topo_rank >= bound : w->topo_rank <= bound) {
+                continue;
+            }
+
+            w->mark = d->mark_epoch;
+            DAG_STAT_ADD(d, enqueues, 1);
+            if (dag_vertex_array_push(found, size, cap, w) < 0) {
+                return -1;
+            }
         }
-        free(e);
+    }
+
+    return 0;
+}
+
+static int dag_cmp_topo_rank(const void *x, const void *y) {
+    const struct Vertex *a = *(struct Vertex * const *) x;
+    const struct Vertex *b = *(struct Vertex * const *) y;
+
+    return (a->topo_rank > b->topo_rank) - (a->topo_rank < b->topo_rank);
+}
+
+static int dag_cmp_int(const void *x, const void *y) {
+    int a = *(const int *) x;
+    int b = *(const int *) y;
 
-        list_remove_after(d->e_list, NULL);
-    }        
+    return (a > b) - (a < b);
+}
 
-    list_destroy(d->v_list);
-    list_destroy(d->e_list);
+/**
+ * Restores the topological order before an edge from a to b is inserted,
+ * where a is currently ranked after b, using the Pearce-Kelly algorithm. Only
+ * vertices ranked between b and a are searched and moved: those reaching a
+ * are placed before those reachable from b, reusing the ranks of both sets.
+ * d - graph containing a and b.
+ * a - start vertex of the new edge.
+ * b - destination vertex of the new edge.
+ * return - 0 if the order was updated; 1 if the edge would close a cycle;
+ *          -1 on allocation failure.
+ */
+static int dag_pk_reorder(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    if (a == b) {
+        return 1;
+    }
+
+    struct Vertex **fwd = NULL;
+    struct Vertex **bwd = NULL;
+    int fwd_size = 0, fwd_cap = 0;
+    int bwd_size = 0, bwd_cap = 0;
+    int *ranks = NULL;
+
+    int res = dag_pk_search(d, b, true, a->topo_rank, a,
+                            &fwd, &fwd_size, &fwd_cap);
+    if (res == 0) {
+        res = dag_pk_search(d, a, false, b->topo_rank, NULL,
+                            &bwd, &bwd_size, &bwd_cap);
+    }
+    if (res == 0) {
+        ranks = malloc((fwd_size + bwd_size) * sizeof(*ranks));
+        if (ranks == NULL) {
+            res = -1;
+        }
+    }
+
+    if (res == 0) {
+        qsort(fwd, fwd_size, sizeof(*fwd), dag_cmp_topo_rank);
+        qsort(bwd, bwd_size, sizeof(*bwd), dag_cmp_topo_rank);
+
+        for (int i = 0; i < bwd_size; i++) {
+            ranks[i] = bwd[i]->topo_rank;
+        }
+        for (int i = 0; i < fwd_size; i++) {
+            ranks[bwd_size + i] = fwd[i]->topo_rank;
+        }
+        qsort(ranks, fwd_size + bwd_size, sizeof(*ranks), dag_cmp_int);
+
+        for (int i = 0; i < bwd_size; i++) {
+            bwd[i]->topo_rank = ranks[i];
+        }
+        for (int i = 0; i < fwd_size; i++) {
+            fwd[i]->topo_rank = ranks[bwd_size + i];
+        }
+    }
+
+    free(fwd);
+    free(bwd);
+    free(ranks);
+
+    return res;
+}
+
+/**
+ * Gets the weight of the given vertex.
+ * returns - the weight of the given vertex.
+ */
+void *dag_v_get_weight(struct Vertex *v) {
+    return v->weight;
+}
+
+/**
+ * Gets the ID of the given vertex
+ * returns - the ID of the given vertex.
+ */
+int dag_v_get_id(struct Vertex *v) {
+    return v->id;
+}
+
+/**
+ * Gets the number of vertices in the graph. Vertex ids are less than this.
+ * Removed vertices are counted until dag_compact().
+ * returns - the number of vertices.
+ */
+int dag_get_vertex_count(struct Dag *d) {
+    return d->id;
+}
+
+/**
+ * Gets the vertex with the given id.
+ * returns - the vertex; null if there is no vertex with that id.
+ */
+struct Vertex *dag_get_vertex(struct Dag *d, int id) {
+    if (id < 0 || id >= d->id || d->vertices[id]->removed) return NULL;
+    return d->vertices[id];
+}
+
+/**
+ * Gets the position of the given vertex in the topological order maintained
+ * by the dag.
+ * returns - the topological rank of v.
+ */
+int dag_v_get_topo_rank(struct Vertex *v) {
+    return v->topo_rank;
+}
+
+/**
+ * Gets the number of edges leaving the given vertex.
+ * returns - the out-degree of v.
+ */
+int dag_v_get_out_degree(struct Vertex *v) {
+    return v->out_size;
+}
+
+/**
+ * Gets the number of edges entering the given vertex.
+ * returns - the in-degree of v.
+ */
+int dag_v_get_in_degree(struct Vertex *v) {
+    return v->in_size;
+}
+
+/**
+ * Gets the i:th outgoing edge of the given vertex.
+ * returns - the edge; null if i is out of range.
+ */
+struct Edge *dag_v_get_out_edge(struct Vertex *v, int i) {
+    if (i < 0 || i >= v->out_size) return NULL;
+    return v->out[i];
+}
+
+/**
+ * Gets the i:th incoming edge of the given vertex.
+ * returns - the edge; null if i is out of range.
+ */
+struct Edge *dag_v_get_in_edge(struct Vertex *v, int i) {
+    if (i < 0 || i >= v->in_size) return NULL;
+    return v->in[i];
+}
+
+/**
+ * Gets the i:th successor of the given vertex.
+ * returns - the vertex; null if i is out of range.
+ */
+struct Vertex *dag_v_get_successor(struct Vertex *v, int i) {
+    if (i < 0 || i >= v->out_size) return NULL;
+    return v->out[i]->to;
+}
+
+/**
+ * Gets the i:th predecessor of the given vertex.
+ * returns - the vertex; null if i is out of range.
+ */
+struct Vertex *dag_v_get_predecessor(struct Vertex *v, int i) {
+    if (i < 0 || i >= v->in_size) return NULL;
+    return v->in[i]->from;
+}
+
+/**
+ * Gets the start vertex of the given edge.
+ * returns - the vertex the edge leaves.
+ */
+struct Vertex *dag_e_get_from(struct Edge *e) {
+    return e->from;
+}
+
+/**
+ * Gets the destination vertex of the given edge.
+ * returns - the vertex the edge enters.
+ */
+struct Vertex *dag_e_get_to(struct Edge *e) {
+    return e->to;
+}
+
+/**
+ * Gets the weight of the given edge.
+ * returns - the weight of the edge.
+ */
+void *dag_e_get_weight(struct Edge *e) {
+    return e->weight;
+}
+
+// Mixes the ids of an edges end points into a hash table position.
+static inline size_t dag_edge_hash(int from, int to) {
+    uint64_t key = ((uint64_t) (unsigned int) from << 32) | (unsigned int) to;
+    key *= 0x9E3779B97F4A7C15ULL;
+    return (size_t) (key ^ (key >> 29));
+}
+
+/**
+ * Searches for an edge between vertex a and vertex b, and returns if it 
+ * exists.
+ * d - dag containing a and b.
+ * a - start vertex.
+ * b - destination vertex.
+ * 
+ * return - the edge from a to b if it exists; null otherwise.
+ */
+struct Edge *dag_find_edge(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    DAG_STAT_CALL(d, DAG_API_FIND_EDGE);
+    if (d->edge_table_size == 0) {
+        return NULL;
+    }
+
+    size_t mask = d->edge_table_cap - 1;
+    size_t i = dag_edge_hash(a->id, b->id) & mask;
+
+    while (d->edge_table[i] != NULL) {
+        struct Edge *e = d->edge_table[i];
+        if (a->id == e->from->id && b->id == e->to->id) {
+            return e;
+        }
+        i = (i + 1) & mask;
+    }
+
+    return NULL;
+}
+
+/**
+ * Makes sure extra more edges can be inserted into the edge hash table 
+ * without exceeding a load factor of 1/2, rehashing into a larger table if
+ * needed.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int dag_edge_table_reserve(struct Dag *d, size_t extra) {
+    if (2 * (d->edge_table_size + extra) <= d->edge_table_cap) {
+        return 0;
+    }
+
+    size_t old_cap = d->edge_table_cap;
+    struct Edge **old = d->edge_table;
+    size_t new_cap = old_cap == 0 ? 16 : old_cap * 2;
+    while (new_cap < 2 * (d->edge_table_size + extra)) {
+        new_cap *= 2;
+    }
+
+    d->edge_table = calloc(new_cap, sizeof(*d->edge_table));
+    if (d->edge_table == NULL) {
+        d->edge_table = old;
+        return -1;
+    }
+    d->edge_table_cap = new_cap;
+    d->edge_table_size = 0;
+
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old[i] != NULL) {
+            dag_edge_table_insert(d, old[i]);
+        }
+    }
+    free(old);
+
+    return 0;
+}
+
+/**
+ * Inserts e into the edge hash table, which must have room for it. Only the
+ * first of several parallel edges is stored, so it is the one found by 
+ * dag_find_edge().
+ */
+static void dag_edge_table_insert(struct Dag *d, struct Edge *e) {
+    size_t mask = d->edge_table_cap - 1;
+    size_t i = dag_edge_hash(e->from->id, e->to->id) & mask;
+
+    while (d->edge_table[i] != NULL) {
+        struct Edge *other = d->edge_table[i];
+        if (e->from->id == other->from->id && e->to->id == other->to->id) {
+            return;
+        }
+        i = (i + 1) & mask;
+    }
+
+    d->edge_table[i] = e;
+    d->edge_table_size++;
+}
+
+/**
+ * Sets how dag_add_edge() treats an edge between two vertices that are 
+ * already connected by an edge.
+ * d - the dag to configure.
+ * mode - DUPLICATES_ALLOW, DUPLICATES_REJECT or DUPLICATES_MERGE.
+ */
+void dag_set_duplicate_edges(struct Dag *d, enum DuplicateEdges mode) {
+    d->duplicates = mode;
+}
+
+/**
+ * Checks if there is some path between vertex a and vertex b.
+ * d - graph containing the vertices
+ * a - starting vertex
+ * b - destination vertex
+ * returns: 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+int dag_is_connected(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    DAG_STAT_CALL(d, DAG_API_IS_CONNECTED);
+    if (d && a && b && d->reach && d->reach->version == d->version) {
+        return dag_reach_index_query(d, a, b);
+    }
+
+    return dag_reachable(d, a, b, SEARCH_FORWARD);
+}
+
+/**
+ * Makes sure the search scratch space can hold every vertex in the graph.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int dag_search_reserve(struct Dag *d) {
+    if (d->search_cap >= d->id) {
+        return 0;
+    }
+
+    int new_cap = d->search_cap * 2 > d->id ? d->search_cap * 2 : d->id;
+    int old_words = (d->search_cap + 63) / 64;
+    int new_words = (new_cap + 63) / 64;
+
+    for (int s = 0; s < 2; s++) {
+        uint64_t *seen = realloc(d->seen[s], new_words * sizeof(*seen));
+        if (seen == NULL) {
+            return -1;
+        }
+        for (int i = old_words; i < new_words; i++) {
+            seen[i] = 0;
+        }
+        d->seen[s] = seen;
+
+        struct Vertex **frontier = realloc(d->frontier[s], 
+                                           new_cap * sizeof(*frontier));
+        if (frontier == NULL) {
+            return -1;
+        }
+        d->frontier[s] = frontier;
+    }
+
+    d->search_cap = new_cap;
+
+    return 0;
+}
+
+static inline bool dag_bit_test(const uint64_t *bits, int i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void dag_bit_set(uint64_t *bits, int i) {
+    bits[i / 64] |= (uint64_t) 1 << (i % 64);
+}
+
+static inline void dag_bit_clear(uint64_t *bits, int i) {
+    bits[i / 64] &= ~((uint64_t) 1 << (i % 64));
+}
+
+/**
+ * Checks if there is some path between vertex a and vertex b, using a
+ * breadth first search that visits every vertex at most once. Vertices
+ * ranked after b in the topological order are never expanded.
+ * 
+ * In bidirectional mode the search also runs backwards from b, always
+ * expanding the smaller of the two frontiers one level at a time, and stops
+ * as soon as the frontiers meet.
+ * d - graph containing the vertices
+ * a - starting vertex
+ * b - destination vertex
+ * mode - SEARCH_FORWARD or SEARCH_BIDIRECTIONAL.
+ * returns: 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+int dag_reachable(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                  enum SearchMode mode) {
+    DAG_STAT_CALL(d, DAG_API_REACHABLE);
+    if (!d || !a || !b) return -1;
+    if (a->id == b->id) return 1;
+    // b is ordered before a, so b can not be reached from a.
+    if (a->topo_rank > b->topo_rank) return 0;
+    if (dag_search_reserve(d) < 0) return -1;
+
+    bool bidirectional = mode == SEARCH_BIDIRECTIONAL;
+    int head[2] = {0, 0};
+    int tail[2] = {0, 0};
+    int res = 0;
+
+    dag_bit_set(d->seen[0], a->id);
+    d->frontier[0][tail[0]++] = a;
+    if (bidirectional) {
+        dag_bit_set(d->seen[1], b->id);
+        d->frontier[1][tail[1]++] = b;
+    }
+
+    while (!res && head[0] < tail[0] 
+            && (!bidirectional || head[1] < tail[1])) {
+        // Side 0 searches forwards from a, side 1 backwards from b.
+        int s = 0;
+        if (bidirectional && tail[1] - head[1] < tail[0] - head[0]) {
+            s = 1;
+        }
+
+        int level_end = tail[s];
+        while (!res && head[s] < level_end) {
+            struct Vertex *v = d->frontier[s][head[s]++];
+            int degree = s == 0 ? v->out_size : v->in_size;
+            DAG_STAT_ADD(d, vertices_visited, 1);
+            DAG_STAT_ADD(d, edges_scanned, degree);
+
+            for (int i = 0; i < degree; i++) {
+                struct Vertex *w = s == 0 ? v->out[i]->to : v->in[i]->from;
+
+                if (dag_bit_test(d->seen[s], w->id)) {
+                    continue;
+                }
+                // Only vertices ranked between a and b can be on the path.
+                if (s == 0 ? w->topo_rank > b->topo_rank 
+                           : w->topo_rank < a->topo_rank) {
+                    continue;
+                }
+                if (bidirectional ? dag_bit_test(d->seen[1 - s], w->id) 
+                                  : w->id == b->id) {
+                    res = 1;
+                    break;
+                }
+
+                dag_bit_set(d->seen[s], w->id);
+                d->frontier[s][tail[s]++] = w;
+                DAG_STAT_ADD(d, enqueues, 1);
+            }
+        }
+    }
+
+    // Only the visited bits are cleared, keeping the cost O(visited).
+    for (int s = 0; s < 2; s++) {
+        for (int i = 0; i < tail[s]; i++) {
+            dag_bit_clear(d->seen[s], d->frontier[s][i]->id);
+        }
+    }
+
+    return res;
+}
+
+/**
+ * Builds a reachability index for the graph, labelling every vertex with
+ * intervals from a depth first search in O(V + E) time. A built index will
+ * be used by dag_is_connected() until the graph is modified.
+ * d - graph to index.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+int dag_reach_index_build(struct Dag *d) {
+    DAG_STAT_CALL(d, DAG_API_REACH_INDEX_BUILD);
+    dag_reach_index_destroy(d);
+
+    struct ReachIndex *r = malloc(sizeof(*r));
+    struct Vertex **stack = malloc(d->id * sizeof(*stack));
+    int *next_edge = malloc(d->id * sizeof(*next_edge));
+
+    if (r) {
+        r->pre = malloc(d->id * sizeof(*r->pre));
+        r->post = malloc(d->id * sizeof(*r->post));
+        r->low = malloc(d->id * sizeof(*r->low));
+    }
+    if (!r || !stack || !next_edge || !r->pre || !r->post || !r->low) {
+        if (r) {
+            free(r->pre);
+            free(r->post);
+            free(r->low);
+        }
+        free(r);
+        free(stack);
+        free(next_edge);
+        return -1;
+    }
+
+    for (int i = 0; i < d->id; i++) {
+        r->pre[i] = -1;
+    }
+
+    int pre = 0;
+    int post = 0;
+    for (int v_id = 0; v_id < d->id; v_id++) {
+        struct Vertex *root = d->vertices[v_id];
+        if (r->pre[root->id] != -1) {
+            continue;
+        }
+
+        int top = 0;
+        stack[top++] = root;
+        next_edge[root->id] = 0;
+        r->pre[root->id] = pre++;
+
+        while (top > 0) {
+            struct Vertex *v = stack[top - 1];
+
+            if (next_edge[v->id] < v->out_size) {
+                struct Vertex *to = v->out[next_edge[v->id]++]->to;
+                if (r->pre[to->id] == -1) {
+                    r->pre[to->id] = pre++;
+                    next_edge[to->id] = 0;
+                    stack[top++] = to;
+                }
+            } else {
+                // In a DAG every successor is finished before v is.
+                DAG_STAT_ADD(d, vertices_visited, 1);
+                DAG_STAT_ADD(d, edges_scanned, 2 * v->out_size);
+                r->post[v->id] = post++;
+                r->low[v->id] = r->post[v->id];
+                for (int j = 0; j < v->out_size; j++) {
+                    int low = r->low[v->out[j]->to->id];
+                    if (low < r->low[v->id]) {
+                        r->low[v->id] = low;
+                    }
+                }
+                top--;
+            }
+        }
+    }
+
+    free(stack);
+    free(next_edge);
+
+    r->size = d->id;
+    r->version = d->version;
+    d->reach = r;
+
+    return 0;
+}
+
+/**
+ * Frees the reachability index of the graph, if it has one.
+ * d - graph owning the index.
+ */
+void dag_reach_index_destroy(struct Dag *d) {
+    if (d->reach == NULL) {
+        return;
+    }
+
+    free(d->reach->pre);
+    free(d->reach->post);
+    free(d->reach->low);
+    free(d->reach);
+    d->reach = NULL;
+}
+
+/**
+ * Checks whether the graph has a reachability index that is up to date.
+ * return - true if the index is used by dag_is_connected(); false otherwise.
+ */
+bool dag_reach_index_is_valid(struct Dag *d) {
+    return d->reach != NULL && d->reach->version == d->version;
+}
+
+/**
+ * Gets the number of bytes used by the reachability index of the graph.
+ * return - the size of the index in bytes; 0 if there is no index.
+ */
+size_t dag_reach_index_memory(struct Dag *d) {
+    if (d->reach == NULL) {
+        return 0;
+    }
+
+    return sizeof(*d->reach) + 3 * (size_t) d->reach->size * sizeof(int);
+}
+
+// b lies in the search subtree of a, so b is reachable from a.
+static inline bool dag_reach_in_tree(struct ReachIndex *r, int a, int b) {
+    return r->pre[a] <= r->pre[b] && r->post[b] <= r->post[a];
+}
+
+// False if b can not be reachable from a.
+static inline bool dag_reach_may_reach(struct ReachIndex *r, int a, int b) {
+    return r->low[a] <= r->low[b] && r->post[b] <= r->post[a];
+}
+
+/**
+ * Answers a reachability query from the interval labels. Most queries are
+ * decided by the labels alone; the rest fall back to a search that only
+ * expands vertices whose labels may still reach b.
+ * returns: 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+static int dag_reach_index_query(struct Dag *d, struct Vertex *a, 
+                                 struct Vertex *b) {
+    struct ReachIndex *r = d->reach;
+
+    if (a->id == b->id) return 1;
+    if (!dag_reach_may_reach(r, a->id, b->id)) return 0;
+    if (dag_reach_in_tree(r, a->id, b->id)) return 1;
+    if (dag_search_reserve(d) < 0) return -1;
+
+    int head = 0;
+    int tail = 0;
+    int res = 0;
+
+    dag_bit_set(d->seen[0], a->id);
+    d->frontier[0][tail++] = a;
+
+    while (!res && head < tail) {
+        struct Vertex *v = d->frontier[0][head++];
+
+        for (int i = 0; i < v->out_size; i++) {
+            struct Vertex *w = v->out[i]->to;
+
+            if (dag_bit_test(d->seen[0], w->id) 
+                    || !dag_reach_may_reach(r, w->id, b->id)) {
+                continue;
+            }
+            if (dag_reach_in_tree(r, w->id, b->id)) {
+                res = 1;
+                break;
+            }
+
+            dag_bit_set(d->seen[0], w->id);
+            d->frontier[0][tail++] = w;
+        }
+    }
+
+    for (int i = 0; i < tail; i++) {
+        dag_bit_clear(d->seen[0], d->frontier[0][i]->id);
+    }
+
+    return res;
+}
+
+/**
+ * Collects the vertices reachable from a in topological order, using an
+ * iterative depth first search and reversing the post-order.
+ * d - graph containing the vertex a.
+ * a - vertex to start from.
+ * n - set to the number of vertices written to the returned array.
+ * return - an array of the reachable vertices, a first, that must be freed
+ *          by the caller; null if memory could not be allocated.
+ */
+static struct Vertex **dag_reachable_topo_order(struct Dag *d, struct Vertex *a,
+                                                int *n) {
+    struct Vertex **order = malloc(d->id * sizeof(*order));
+    struct Vertex **stack = malloc(d->id * sizeof(*stack));
+    int *next_edge = malloc(d->id * sizeof(*next_edge));
+    bool *visited = calloc(d->id, sizeof(*visited));
+
+    if (!order || !stack || !next_edge || !visited) {
+        free(order);
+        free(stack);
+        free(next_edge);
+        free(visited);
+        return NULL;
+    }
+
+    int top = 0;
+    int count = 0;
+    stack[top++] = a;
+    next_edge[a->id] = 0;
+    visited[a->id] = true;
+
+    while (top > 0) {
+        struct Vertex *v = stack[top - 1];
+
+        if (next_edge[v->id] < v->out_size) {
+            struct Vertex *to = v->out[next_edge[v->id]++]->to;
+            if (!visited[to->id]) {
+                visited[to->id] = true;
+                next_edge[to->id] = 0;
+                stack[top++] = to;
+            }
+        } else {
+            // All descendants of v are done, so v goes before all of them.
+            DAG_STAT_ADD(d, vertices_visited, 1);
+            DAG_STAT_ADD(d, edges_scanned, v->out_size);
+            order[d->id - 1 - count++] = v;
+            top--;
+        }
+    }
+
+    // The order was filled from the back; move it to the front.
+    for (int i = 0; i < count; i++) {
+        order[i] = order[d->id - count + i];
+    }
+
+    free(stack);
+    free(next_edge);
+    free(visited);
+
+    *n = count;
+    return order;
+}
+
+/**
+ * Adds the weights w and x using the dags add function and frees w.
+ * return - the new weight.
+ */
+static void *dag_add_and_free(struct Dag *d, void *w, void *x) {
+    void *res = d->add(w, x);
+    free(w);
+    return res;
+}
+
+/**
+ * Computes the longest path between the vertices a and b, by relaxing the
+ * edges of the vertices reachable from a in topological order. Runs in
+ * O(V + E) time.
+ * d - graph containing the vertices and edges.
+ * a - Path start
+ * b - Path end
+ * f - function for interpreting the weight of the vertices
+ * g - function for interpreting the weight of the edges.
+ * path - if not null, set to a list of the vertices on the longest path.
+ * return - the weight of the longest path between a and b; null if there is
+ *          no such path or an error occurred.
+ */
+void *dag_longest_path(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                       get_weight_func f, get_weight_func g,
+                       struct list **path) {
+    DAG_STAT_CALL(d, DAG_API_LONGEST_PATH);
+    if (path) *path = NULL;
+    if (!d || !a || !b) return NULL;
+    if (!f || !g || !d->add || !d->comp) return NULL;
+
+    int n;
+    struct Vertex **order = dag_reachable_topo_order(d, a, &n);
+    void **best = calloc(d->id, sizeof(*best));
+    struct Edge **pred = calloc(d->id, sizeof(*pred));
+
+    if (!order || !best || !pred) {
+        free(order);
+        free(best);
+        free(pred);
+        return NULL;
+    }
+
+    best[a->id] = d->add(NULL, f(a->weight));
+    DAG_STAT_ADD(d, weight_calls, 2);
+
+    for (int i = 0; i < n; i++) {
+        struct Vertex *u = order[i];
+        if (u->id == b->id) {
+            // Nothing after b in the order can lie on a path to b.
+            break;
+        }
+        // Each relaxation calls add twice, f, g and compare.
+        DAG_STAT_ADD(d, vertices_visited, 1);
+        DAG_STAT_ADD(d, edges_scanned, u->out_size);
+        DAG_STAT_ADD(d, weight_calls, 5 * u->out_size);
+
+        for (int j = 0; j < u->out_size; j++) {
+            struct Edge *e = u->out[j];
+            struct Vertex *v = e->to;
+
+            void *w = d->add(best[u->id], g(e->weight));
+            w = dag_add_and_free(d, w, f(v->weight));
+
+            if (best[v->id] == NULL 
+                    || d->comp(w, best[v->id]) == GREATER_THAN) {
+                free(best[v->id]);
+                best[v->id] = w;
+                pred[v->id] = e;
+            } else {
+                free(w);
+            }
+        }
+    }
+
+    void *res = best[b->id];
+    best[b->id] = NULL;
+
+    if (res && path) {
+        *path = list_create();
+        struct Vertex *v = b;
+        list_insert_after(*path, NULL, v);
+        while (v->id != a->id) {
+            v = pred[v->id]->from;
+            list_insert_after(*path, NULL, v);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(best[order[i]->id]);
+    }
+    free(order);
+    free(best);
+    free(pred);
+
+    return res;
+}
+
+/**
+ * Computes the weight of the longest path between the vertices a and b.
+ * d - graph containing the vertices and edges.
+ * a - Path start
+ * b - Path end
+ * f - function for interpreting the weight of the vertices
+ * g - function for interpreting the weight of the edges.
+ * return - the weight of the longest path between a and b. NULL is returned if 
+ * f or g are NULL, or if `add` and `compare` functions are not defined.
+ */
+void *dag_weight_of_longest_path(struct Dag *d,
+                                struct Vertex *a, struct Vertex *b,
+                                get_weight_func f, get_weight_func g) {
+    return dag_longest_path(d, a, b, f, g, NULL);
+}
+
+/**
+ * Computes the best path weight from any of the sources to every vertex, by
+ * relaxing the edges of the whole graph in its cached topological order.
+ * Vertices that are not yet reached when their turn comes are skipped.
+ * better - GREATER_THAN for longest paths, LESS_THAN for shortest paths.
+ * return - 0 on success; -1 if an error occurred.
+ */
+static int dag_sweep_paths(struct Dag *d, struct Vertex **sources, 
+                           int n_sources, get_weight_func f, 
+                           get_weight_func g, enum WeightComp better,
+                           void **dist, struct Edge **pred) {
+    DAG_STAT_CALL(d, DAG_API_PATHS_FROM);
+    if (!d || !sources || n_sources < 0 || !dist) return -1;
+    if (!f || !g || !d->add || !d->comp) return -1;
+
+    int n;
+    struct Vertex **order = dag_topological_order(d, &n);
+    if (!order) return -1;
+
+    // The order leaves out removed vertices, but dist is indexed by id.
+    for (int i = 0; i < d->id; i++) {
+        dist[i] = NULL;
+        if (pred) pred[i] = NULL;
+    }
+    for (int i = 0; i < n_sources; i++) {
+        struct Vertex *s = sources[i];
+        if (s && dist[s->id] == NULL) {
+            dist[s->id] = d->add(NULL, f(s->weight));
+            DAG_STAT_ADD(d, weight_calls, 2);
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct Vertex *u = order[i];
+        if (dist[u->id] == NULL) {
+            continue;
+        }
+        // Each relaxation calls add twice, f, g and compare.
+        DAG_STAT_ADD(d, vertices_visited, 1);
+        DAG_STAT_ADD(d, edges_scanned, u->out_size);
+        DAG_STAT_ADD(d, weight_calls, 5 * u->out_size);
+
+        for (int j = 0; j < u->out_size; j++) {
+            struct Edge *e = u->out[j];
+            struct Vertex *v = e->to;
+
+            void *w = d->add(dist[u->id], g(e->weight));
+            w = dag_add_and_free(d, w, f(v->weight));
+
+            if (dist[v->id] == NULL || d->comp(w, dist[v->id]) == better) {
+                free(dist[v->id]);
+                dist[v->id] = w;
+                if (pred) pred[v->id] = e;
+            } else {
+                free(w);
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Computes the weight of the longest path from a to every vertex in a single
+ * sweep over topological order, in O(V + E) time. The weight of a path is the
+ * sum of its vertex and edge weights.
+ * d - graph containing the vertices and edges.
+ * a - Path start
+ * f - function for interpreting the weight of the vertices
+ * g - function for interpreting the weight of the edges.
+ * dist - array of dag_get_vertex_count(d) elements, indexed by vertex id,
+ *        receiving the weight of the longest path from a. The weights must be
+ *        freed by the caller. Vertices that can not be reached get null.
+ * pred - if not null, array of dag_get_vertex_count(d) elements receiving the
+ *        last edge of the path to each vertex; null for a and for vertices 
+ *        that can not be reached.
+ * return - 0 on success; -1 if an error occurred, or if f or g are NULL, or
+ *          `add` and `compare` are not defined.
+ */
+int dag_longest_paths_from(struct Dag *d, struct Vertex *a,
+                           get_weight_func f, get_weight_func g,
+                           void **dist, struct Edge **pred) {
+    if (!a) return -1;
+    return dag_sweep_paths(d, &a, 1, f, g, GREATER_THAN, dist, pred);
+}
+
+/**
+ * Computes the weight of the shortest path from a to every vertex in a single
+ * sweep over topological order. See dag_longest_paths_from().
+ */
+int dag_shortest_paths_from(struct Dag *d, struct Vertex *a,
+                            get_weight_func f, get_weight_func g,
+                            void **dist, struct Edge **pred) {
+    if (!a) return -1;
+    return dag_sweep_paths(d, &a, 1, f, g, LESS_THAN, dist, pred);
+}
+
+/**
+ * Computes the weight of the longest path from any of the sources to every
+ * vertex in a single sweep. See dag_longest_paths_from().
+ */
+int dag_longest_paths_from_sources(struct Dag *d, struct Vertex **sources,
+                                   int n_sources, get_weight_func f, 
+                                   get_weight_func g, void **dist, 
+                                   struct Edge **pred) {
+    return dag_sweep_paths(d, sources, n_sources, f, g, GREATER_THAN, 
+                           dist, pred);
+}
+
+/**
+ * Computes the weight of the shortest path from any of the sources to every
+ * vertex in a single sweep. See dag_longest_paths_from().
+ */
+int dag_shortest_paths_from_sources(struct Dag *d, struct Vertex **sources,
+                                    int n_sources, get_weight_func f, 
+                                    get_weight_func g, void **dist, 
+                                    struct Edge **pred) {
+    return dag_sweep_paths(d, sources, n_sources, f, g, LESS_THAN, 
+                           dist, pred);
+}
+
+/**
+ * Counts the paths from a to every vertex in one pass over the vertices
+ * reachable from a in topological order. Counts saturate at UINT64_MAX.
+ * d - dag containing the vertex a.
+ * a - Starting vertex
+ * counts - array of dag_get_vertex_count(d) elements, indexed by vertex id,
+ *          receiving the number of paths from a. Vertices that can not be
+ *          reached get 0, and a itself 1.
+ * return - 0 on success; -1 if an error occurred.
+ */
+int dag_count_paths_from(struct Dag *d, struct Vertex *a, uint64_t *counts) {
+    DAG_STAT_CALL(d, DAG_API_COUNT_PATHS);
+    if (!d || !a || !counts) return -1;
+
+    int n;
+    struct Vertex **order = dag_reachable_topo_order(d, a, &n);
+    if (order == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < d->id; i++) {
+        counts[i] = 0;
+    }
+    counts[a->id] = 1;
+
+    for (int i = 0; i < n; i++) {
+        struct Vertex *u = order[i];
+        DAG_STAT_ADD(d, vertices_visited, 1);
+        DAG_STAT_ADD(d, edges_scanned, u->out_size);
+        for (int j = 0; j < u->out_size; j++) {
+            uint64_t *c = &counts[u->out[j]->to->id];
+            *c = UINT64_MAX - *c < counts[u->id] ? UINT64_MAX 
+                                                 : *c + counts[u->id];
+        }
+    }
+
+    free(order);
+
+    return 0;
+}
+
+/**
+ * Counts the paths from a to b without enumerating them, in O(V + E) time.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * return - the number of paths; UINT64_MAX if there are at least that many.
+ *          0 is also returned if an error occurred.
+ */
+uint64_t dag_count_paths(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    if (!d || !a || !b) return 0;
+
+    uint64_t *counts = malloc(d->id * sizeof(*counts));
+    if (counts == NULL || dag_count_paths_from(d, a, counts) < 0) {
+        free(counts);
+        return 0;
+    }
+
+    uint64_t res = counts[b->id];
+    free(counts);
+
+    return res;
+}
+
+// An unsigned integer of any size, stored as base 2^32 limbs, least 
+// significant first.
+struct BigCount {
+    uint32_t *limbs;
+    int size;
+};
+
+/**
+ * Adds x to sum.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int big_count_add(struct BigCount *sum, const struct BigCount *x) {
+    int size = (sum->size > x->size ? sum->size : x->size) + 1;
+    uint32_t *limbs = realloc(sum->limbs, size * sizeof(*limbs));
+    if (limbs == NULL) {
+        return -1;
+    }
+    for (int i = sum->size; i < size; i++) {
+        limbs[i] = 0;
+    }
+
+    uint64_t carry = 0;
+    for (int i = 0; i < size; i++) {
+        uint64_t t = (uint64_t) limbs[i] + carry;
+        if (i < x->size) {
+            t += x->limbs[i];
+        }
+        limbs[i] = (uint32_t) t;
+        carry = t >> 32;
+    }
+
+    while (size > 0 && limbs[size - 1] == 0) {
+        size--;
+    }
+    sum->limbs = limbs;
+    sum->size = size;
+
+    return 0;
+}
+
+/**
+ * Formats x as a decimal number, destroying x in the process.
+ * return - a string that must be freed by the caller; null on failure.
+ */
+static char *big_count_to_string(struct BigCount *x) {
+    // Every limb holds less than 10 decimal digits.
+    char *str = malloc(10 * x->size + 2);
+    if (str == NULL) {
+        return NULL;
+    }
+
+    int len = 0;
+    do {
+        // Divide by 10 in place and collect the remainder.
+        uint64_t rem = 0;
+        for (int i = x->size - 1; i >= 0; i--) {
+            uint64_t t = (rem << 32) | x->limbs[i];
+            x->limbs[i] = (uint32_t) (t / 10);
+            rem = t % 10;
+        }
+        str[len++] = '0' + rem;
+
+        while (x->size > 0 && x->limbs[x->size - 1] == 0) {
+            x->size--;
+        }
+    } while (x->size > 0);
+
+    for (int i = 0; i < len / 2; i++) {
+        char c = str[i];
+        str[i] = str[len - 1 - i];
+        str[len - 1 - i] = c;
+    }
+    str[len] = '\0';
+
+    return str;
+}
+
+/**
+ * Counts the paths from a to b exactly, however many there are, in 
+ * O((V + E) * L) time where L is the number of digits of the result.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * return - the number of paths as a decimal string, which must be freed by
+ *          the caller; null if an error occurred.
+ */
+char *dag_count_paths_big(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    DAG_STAT_CALL(d, DAG_API_COUNT_PATHS);
+    if (!d || !a || !b) return NULL;
+
+    int n;
+    struct Vertex **order = dag_reachable_topo_order(d, a, &n);
+    struct BigCount *counts = calloc(d->id, sizeof(*counts));
+    uint32_t *one = malloc(sizeof(*one));
+    char *res = NULL;
+
+    if (!order || !counts || !one) {
+        free(order);
+        free(counts);
+        free(one);
+        return NULL;
+    }
+
+    *one = 1;
+    counts[a->id].limbs = one;
+    counts[a->id].size = 1;
+
+    int err = 0;
+    for (int i = 0; i < n && !err && order[i] != b; i++) {
+        struct Vertex *u = order[i];
+        for (int j = 0; j < u->out_size && !err; j++) {
+            struct Vertex *to = u->out[j]->to;
+            err = big_count_add(&counts[to->id], &counts[u->id]);
+        }
+    }
+
+    if (!err) {
+        res = big_count_to_string(&counts[b->id]);
+    }
+
+    for (int i = 0; i < n; i++) {
+        free(counts[order[i]->id].limbs);
+    }
+    free(counts);
+    free(order);
+
+    return res;
+}
+
+/**
+ * Orders the vertices topologically with Kahn's algorithm. The in-degrees
+ * are counted down in a side array, leaving the graph untouched, and the 
+ * order array doubles as the queue of vertices without remaining incoming 
+ * edges. The result is cached until the graph is modified.
+ * d - graph containing the vertices to sort.
+ * n - if not null, receives the number of vertices.
+ * return - the vertices in topological order, owned by the graph and valid
+ *          until it is modified; null if an error occurred.
+ */
+struct Vertex **dag_topological_order(struct Dag *d, int *n) {
+    DAG_STAT_CALL(d, DAG_API_TOPOLOGICAL_ORDER);
+    if (!d) return NULL;
+
+    if (d->topo_order == NULL || d->topo_order_version != d->version) {
+        int v_count = d->id;
+        struct Vertex **order = realloc(d->topo_order, 
+                                        (v_count + 1) * sizeof(*order));
+        int *in_degree = malloc((v_count + 1) * sizeof(*in_degree));
+        if (!order || !in_degree) {
+            // realloc() leaves the old array in place on failure.
+            if (order) d->topo_order = order;
+            free(in_degree);
+            return NULL;
+        }
+        d->topo_order = order;
+        d->topo_order_cap = v_count + 1;
+
+        // Tombstones have no edges, and are left out of the order until 
+        // the end.
+        int tail = 0;
+        for (int i = 0; i < v_count; i++) {
+            struct Vertex *v = d->vertices[i];
+            in_degree[i] = v->in_size;
+            if (v->in_size == 0 && !v->removed) {
+                order[tail++] = v;
+            }
+        }
+
+        for (int head = 0; head < tail; head++) {
+            struct Vertex *v = order[head];
+            DAG_STAT_ADD(d, vertices_visited, 1);
+            DAG_STAT_ADD(d, edges_scanned, v->out_size);
+            for (int i = 0; i < v->out_size; i++) {
+                struct Vertex *to = v->out[i]->to;
+                if (--in_degree[to->id] == 0) {
+                    DAG_STAT_ADD(d, enqueues, 1);
+                    order[tail++] = to;
+                }
+            }
+        }
+
+        for (int i = 0; i < v_count; i++) {
+            if (d->vertices[i]->removed) {
+                order[tail++] = d->vertices[i];
+            }
+        }
+
+        free(in_degree);
+        d->topo_order_version = d->version;
+    }
+
+    if (n) *n = d->id - d->n_removed;
+    return d->topo_order;
+}
+
+/**
+ * Performs a topological ordering, using Kahn's algorithm.
+ * dag - graph containing the vertices to sort.
+ * return - A list containing the sorted elements. This list must be 
+ *          freed by calling dag_destroy_path() to avoid memory leaks.
+ */
+struct list *dag_topological_ordering(struct Dag *d) {
+    int n;
+    struct Vertex **order = dag_topological_order(d, &n);
+    if (!order) return NULL;
+
+    struct list *sorted_list = list_create();
+    if (!sorted_list) return NULL;
+
+    // Append after the last node, rather than walk the list for each vertex.
+    struct node *last = NULL;
+    for (int i = 0; i < n; i++) {
+        last = list_insert_after(sorted_list, last, order[i]);
+    }
+
+    return sorted_list;
+}
+
+/**
+ * Enumerates the paths from a to b with a depth first search, calling visit
+ * for each path found. The search keeps only the current path, so memory 
+ * use is proportional to the length of the longest path. Vertices ranked 
+ * after b in the topological order are never entered.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * visit - called with each path; returning non-zero stops the enumeration.
+ * ctx - passed on to visit.
+ * return - 0 if all paths were visited; 1 if visit stopped the enumeration;
+ *          -1 if an error occurred.
+ */
+int dag_foreach_path(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                     path_visit_func visit, void *ctx) {
+    DAG_STAT_CALL(d, DAG_API_FOREACH_PATH);
+    if (!d || !a || !b || !visit) return -1;
+
+    int cap = 16;
+    struct Vertex **path = malloc(cap * sizeof(*path));
+    int *next_edge = malloc(cap * sizeof(*next_edge));
+    if (!path || !next_edge) {
+        free(path);
+        free(next_edge);
+        return -1;
+    }
+
+    int res = 0;
+    int len = 1;
+    path[0] = a;
+    next_edge[0] = 0;
+
+    if (a->id == b->id) {
+        res = visit(path, len, ctx) != 0;
+        len = 0;
+    }
+
+    while (len > 0) {
+        struct Vertex *v = path[len - 1];
+
+        if (next_edge[len - 1] == v->out_size) {
+            len--;
+            continue;
+        }
+
+        struct Vertex *w = v->out[next_edge[len - 1]++]->to;
+        if (w->topo_rank > b->topo_rank) {
+            continue;
+        }
+
+        if (len == cap) {
+            cap *= 2;
+            struct Vertex **new_path = realloc(path, cap * sizeof(*path));
+            if (new_path) path = new_path;
+            int *new_next = realloc(next_edge, cap * sizeof(*next_edge));
+            if (new_next) next_edge = new_next;
+            if (!new_path || !new_next) {
+                res = -1;
+                break;
+            }
+        }
+
+        path[len] = w;
+        next_edge[len] = 0;
+        len++;
+
+        if (w->id == b->id) {
+            if (visit(path, len, ctx) != 0) {
+                res = 1;
+                break;
+            }
+            // No path to b continues through b.
+            len--;
+        }
+    }
+
+    free(path);
+    free(next_edge);
+
+    return res;
+}
+
+// The list of paths built by dag_get_all_paths() and its last node.
+struct PathCollector {
+    struct list *all_paths;
+    struct node *last;
+};
+
+static int dag_collect_path(struct Vertex **path, int len, void *ctx) {
+    struct PathCollector *c = ctx;
+    struct list *l = list_create();
+    if (l == NULL) {
+        return 1;
+    }
+
+    for (int i = len - 1; i >= 0; i--) {
+        list_insert_after(l, NULL, path[i]);
+    }
+
+    c->last = list_insert_after(c->all_paths, c->last, l);
+
+    return 0;
+}
+
+/**
+ * Traverses the graph and creates a list of paths between the vertices 
+ * that is then returned.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * return - The path between a and b. This list must be destroy with
+ *          dag_all_paths_list_destroy()
+ */
+struct list *dag_get_all_paths(struct Dag *d, struct Vertex *a, struct Vertex *b) {
+    DAG_STAT_CALL(d, DAG_API_GET_ALL_PATHS);
+    struct PathCollector c;
+    c.all_paths = list_create();
+    c.last = NULL;
+
+    dag_foreach_path(d, a, b, dag_collect_path, &c);
+
+    return c.all_paths;
+}
+
+/**
+ * Cleans up dynamically allocated resources. This will destroy the graph,
+ * vertices and edges. In ALLOC_ARENA mode the vertices and edges are freed
+ * together with their slabs, without visiting them unless free_weight is set.
+ * d - cleans up the resources used by the dag.
+ * free_weight - if set to true, this function will free the weights used
+ *               by the vertices and edges. Must be set to false if the weights
+ *               are not dynamically allocated.
+ */
+int dag_destroy(struct Dag *d, bool free_weight) {
+    if (free_weight || !d->arena) {
+        for (int i = 0; i < d->id; i++) {
+            struct Vertex *v = d->vertices[i];
+            if (free_weight)
+                free(v->weight);
+            dag_free(d, v->out, v->out_cap * sizeof(*v->out));
+            dag_free(d, v->in, v->in_cap * sizeof(*v->in));
+            dag_free(d, v, sizeof(*v));
+        }
+
+        for (int i = 0; i < d->e_size; i++) {
+            struct Edge *e = d->edges[i];
+            if (free_weight) {
+                free(e->weight);
+            }
+            dag_free(d, e, sizeof(*e));
+        }
+    }
+
+    if (d->arena) {
+        arena_destroy(d->arena);
+    }
+    free(d->vertices);
+    free(d->edges);
+    free(d->topo_order);
+
+    for (int s = 0; s < 2; s++) {
+        free(d->seen[s]);
+        free(d->frontier[s]);
+    }
+    dag_reach_index_destroy(d);
+    free(d->edge_table);
 
     free(d);
 
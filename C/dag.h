@@ -1,6 +1,9 @@
 #ifndef DAG_H
 #define DAG_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include "list.h"
 
 // Functions for comparing weights of the same type must follow this format.
@@ -17,10 +20,144 @@ enum WeightComp {
     EQUAL
 };
 
-// These structs are defined in dag.c to hide internal representation.
+// Defines how dag_reachable() searches the graph.
+enum SearchMode {
+    SEARCH_FORWARD,
+    SEARCH_BIDIRECTIONAL
+};
+
+// Defines how dag_add_edge() treats an edge parallel to an existing one.
+enum DuplicateEdges {
+    // The edge is added next to the existing one.
+    DUPLICATES_ALLOW,
+    // The edge is not added and dag_add_edge() fails.
+    DUPLICATES_REJECT,
+    // The edge is not added, the existing one is kept and dag_add_edge() 
+    // succeeds. The new weight is not stored and is still owned by the caller.
+    DUPLICATES_MERGE
+};
+
+// Defines how a dag allocates its vertices, edges and adjacency arrays.
+enum AllocMode {
+    // Every element is allocated with its own malloc().
+    ALLOC_MALLOC,
+    // Elements are carved out of large slabs that are freed all at once.
+    ALLOC_ARENA
+};
+
+// These structs are defined in dag_internal.h to hide internal representation.
 struct Vertex;
 struct Edge;
 struct Dag;
+// Keys of the vertices loaded by dag_load_edge_list(), defined in dag_load.c.
+struct EdgeList;
+// Read-only graph mapped from a file by dag_open_mmap(), defined in 
+// dag_snapshot.c.
+struct DagSnapshot;
+// A graph shared between a writer and concurrent readers, a reader of it, 
+// and an immutable view read by them, defined in dag_concurrent.c.
+struct DagShared;
+struct DagReader;
+struct DagView;
+// A graph staged by several threads at once, and the staging area of one of
+// them, defined in dag_build.c.
+struct DagBuilder;
+struct DagBuildHandle;
+// Reachability bitsets built by dag_closure_build(), defined in 
+// dag_closure.c.
+struct DagClosure;
+
+// Defines how dag_load_edge_list() interprets the vertex keys of a file.
+enum LoadKeys {
+    // Keys are arbitrary strings, compared byte by byte.
+    KEYS_STRING,
+    // Keys are decimal integers, so "7" and "+07" are the same vertex.
+    KEYS_INTEGER
+};
+
+// Statistics of a dag_load_edge_list() call.
+struct LoadResult {
+    int64_t lines;
+    int64_t bytes;
+    int edges;
+    int vertices;
+    double seconds;
+    double lines_per_second;
+    double bytes_per_second;
+    // Line that could not be parsed; 0 if there was none.
+    int64_t error_line;
+    // First line whose edge, together with the lines before it, closes a
+    // cycle; 0 if there was none.
+    int64_t cycle_line;
+};
+
+// API functions whose calls are counted and timed in struct DagStats.
+enum DagApi {
+    DAG_API_ADD_VERTEX,
+    DAG_API_ADD_EDGE,
+    DAG_API_ADD_EDGES_BULK,
+    DAG_API_FIND_EDGE,
+    DAG_API_REACHABLE,
+    DAG_API_IS_CONNECTED,
+    DAG_API_REACH_INDEX_BUILD,
+    DAG_API_LONGEST_PATH,
+    DAG_API_PATHS_FROM,
+    DAG_API_COUNT_PATHS,
+    DAG_API_FOREACH_PATH,
+    DAG_API_GET_ALL_PATHS,
+    DAG_API_TOPOLOGICAL_ORDER,
+    DAG_API_TOPOLOGICAL_LEVELS,
+    DAG_API_EXECUTE,
+    DAG_API_SAVE,
+    DAG_API_LOAD_EDGE_LIST,
+    DAG_API_REMOVE_EDGE,
+    DAG_API_REMOVE_VERTEX,
+    DAG_API_TRANSITIVE_REDUCTION,
+    DAG_API_CLOSURE_BUILD,
+    DAG_API_COMPACT,
+    DAG_API_COUNT
+};
+
+// Operation counters of a dag, see dag_stats_get(). Only collected when the
+// library is compiled with DAG_STATS defined.
+struct DagStats {
+    // Edges followed and vertices expanded by searches and sweeps.
+    uint64_t edges_scanned;
+    uint64_t vertices_visited;
+    // Vertices added to the work lists of searches and sweeps.
+    uint64_t enqueues;
+    // Calls of the add, compare and weight interpreting functions.
+    uint64_t weight_calls;
+    // Allocations of vertices, edges and adjacency arrays.
+    uint64_t allocations;
+    // Bytes currently held by the dag, weights excluded.
+    uint64_t bytes_live;
+    // Calls of each API function, and their total wall time. The time of a
+    // call includes that of the API functions it calls itself.
+    uint64_t calls[DAG_API_COUNT];
+    uint64_t nanoseconds[DAG_API_COUNT];
+};
+
+// Topological levels of a dag, see dag_topological_levels(). The ids of the
+// vertices in level i are ids[level_start[i]] to ids[level_start[i + 1] - 1].
+struct TopoLevels {
+    int n_levels;
+    int n_ids;
+    int *level_start;
+    int *ids;
+};
+
+// Functions visiting the paths found by dag_foreach_path() must follow this
+// format. They return non-zero to stop the enumeration.
+typedef int (*path_visit_func)(struct Vertex **path, int len, void *ctx);
+
+// Functions serializing weights for dag_save() must follow this format. They
+// return the bytes representing the weight and set size to their number.
+typedef const void *(*weight_bytes_func)(void *w, size_t *size);
+
+// Tasks run by dag_execute() must follow this format. They return non-zero
+// to stop the execution.
+typedef int (*task_func)(struct Vertex *v, void *ctx);
 
 /**
  * Creates a new dag.
@@ -28,6 +165,18 @@ struct Dag;
  */
 struct Dag *dag_create(add_weight_func add_func, weight_comp_func comp_func);
 
+/**
+ * Creates a new dag, allocating its vertices and edges as given by mode. 
+ * With ALLOC_ARENA, vertices, edges and adjacency arrays are allocated from 
+ * slabs of growing size, and dag_destroy() releases them with one free() per
+ * slab. Memory freed by growing adjacency arrays or by removing vertices and
+ * edges is kept in the arena and reused by later allocations.
+ * return - the new dag on success; null on error.
+ */
+struct Dag *dag_create_with_alloc(add_weight_func add_func, 
+                                  weight_comp_func comp_func,
+                                  enum AllocMode mode);
+
 /**
  * Adds a new vertex to the graph. The Vertex will have weight w
  * reutrns - the new vertex if it was created successfully, NULL otherwise.
@@ -36,12 +185,183 @@ struct Vertex *dag_add_vertex(struct Dag *d, void *w);
 
 /**
  * Adds an edge between a and b to the graph. The edge will be w.
- * Failure to add the edge could be because the edge would introduce a cycle.
+ * Failure to add the edge could be because the edge would introduce a cycle,
+ * or because a or b has been removed.
+ * Cycles are detected using a topological order maintained by the dag: an
+ * edge that agrees with the order is added in O(1), otherwise only vertices
+ * ranked between b and a are searched and reordered.
  * 
  * return - 0 if the edge was added; -1 on failure.
  */
 int dag_add_edge(struct Dag *d, struct Vertex *a, struct Vertex *b, void *w);
 
+/**
+ * Adds n edges to the graph at once. The edges are appended without the
+ * per-edge cycle check of dag_add_edge(); instead the whole graph is checked
+ * once with Kahn's algorithm, in O(V + E) time. The insert is atomic: if the
+ * edges would create a cycle, or anything else fails, none of them is added.
+ * Duplicates are handled as set by dag_set_duplicate_edges().
+ * d - dag to insert the edges into
+ * from - start vertices of the edges.
+ * to - destination vertices of the edges.
+ * weights - weights of the edges; may be null to give every edge a null
+ *           weight.
+ * n - number of edges.
+ * cyclic - if not null, an array of n elements that receives the indices of
+ *          the edges that would lie on a cycle, if the edges would create
+ *          cycles. Every cycle consists of such edges and edges already in
+ *          the graph, and every such edge is on a cycle.
+ * n_cyclic - if not null, set to the number of indices written to cyclic;
+ *            0 if the edges were added or failed for another reason.
+ * return - 0 if all edges were added; -1 if none were.
+ */
+int dag_add_edges_bulk(struct Dag *d, struct Vertex **from, struct Vertex **to,
+                       void **weights, int n, int *cyclic, int *n_cyclic);
+
+/**
+ * Removes the edge between vertex a and vertex b, as found by 
+ * dag_find_edge(), in time proportional to the out-degree of a. The last
+ * edge of each adjacency array it was in takes its place there.
+ * d - dag containing the edge.
+ * a - start vertex.
+ * b - destination vertex.
+ * free_weight - if true, the weight of the edge is freed.
+ * return - 0 if the edge was removed; -1 if there is no such edge.
+ */
+int dag_remove_edge(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                    bool free_weight);
+
+/**
+ * Removes a vertex and all of its edges, in time proportional to its 
+ * degree. The ids of the other vertices do not change: the vertex is left
+ * as a tombstone without edges, which keeps its id and is never handed out
+ * again. Tombstones are skipped by dag_get_vertex() and the topological
+ * orders, and dag_add_edge() and dag_remove_vertex() fail for them, so a
+ * pointer kept from before the removal can not reach another vertex. The
+ * edges and adjacency arrays are freed right away, and the tombstones 
+ * themselves by dag_compact().
+ * d - dag containing the vertex.
+ * v - vertex to remove.
+ * free_weight - if true, the weights of the vertex and its edges are freed.
+ * return - 0 if the vertex was removed; -1 if it already was.
+ */
+int dag_remove_vertex(struct Dag *d, struct Vertex *v, bool free_weight);
+
+/**
+ * Frees the tombstones left by dag_remove_vertex(), and renumbers the 
+ * remaining vertices from 0, keeping their relative order. Their pointers
+ * stay valid, but their ids change as given by the returned map; pointers
+ * to removed vertices must not be used afterwards. Call it periodically to
+ * bound the memory of a graph with many removals. Runs in O(V + E) time.
+ * d - dag to compact.
+ * n - if not null, receives the number of entries in the map: the vertex
+ *     count before compaction.
+ * return - an array mapping each old id to the new id, or to -1 for removed
+ *          vertices, to be freed with free(); null if an error occurred, in
+ *          which case the graph is unchanged.
+ */
+int *dag_compact(struct Dag *d, int *n);
+
+/**
+ * Finds a minimal set of edges with the same reachability as the graph: the
+ * transitive reduction. An edge a -> b is redundant if b can also be
+ * reached from another successor of a, or if it is parallel to an earlier
+ * edge. Reachability is computed with bitsets over blocks of the 
+ * topological order, in O(V * E / 64) time and max(64 MB, 8 * V bytes) of
+ * bitsets, without searching the graph once per edge.
+ * d - graph to reduce.
+ * n - receives the number of redundant edges.
+ * return - the redundant edges, to be freed with free(); null if an error
+ *          occurred.
+ */
+struct Edge **dag_transitive_reduction(struct Dag *d, int *n);
+
+/**
+ * Removes the redundant edges found by dag_transitive_reduction(), leaving
+ * the transitive reduction of the graph.
+ * d - graph to reduce.
+ * free_weight - if true, the weights of the removed edges are freed.
+ * return - the number of edges removed; -1 if an error occurred.
+ */
+int dag_transitive_reduce(struct Dag *d, bool free_weight);
+
+/**
+ * Builds the transitive closure of the graph as bitsets: for every vertex,
+ * the set of target vertices it can reach and, optionally, the set of 
+ * target vertices that can reach it. Vertices are visited in reverse 
+ * topological order, and each ORs the descendant sets of its successors
+ * into its own, 256 bits at a time with AVX2 where the processor supports
+ * it, otherwise with SSE2 or 64 bit words. Only vertices that can have 
+ * target descendants are visited.
+ *
+ * Each set takes ceil(n_ids / 256) * 32 bytes per vertex, so the full 
+ * closure takes about V^2 / 8 bytes per direction: 125 KB for 10^3 
+ * vertices, but 1.25 GB for 10^5. Large graphs can instead be processed in
+ * tiles of target vertices, building one closure per range of ids with 
+ * memory proportional to V * n_ids.
+ * d - graph to build the closure of. 
+ * first_id - id of the first target vertex; 0 for the full closure.
+ * n_ids - number of target vertices; dag_get_vertex_count(d) for the full
+ *         closure.
+ * ancestors - if true, the ancestor sets are built too, doubling the cost.
+ * return - the closure, valid until the graph is modified and to be freed
+ *          with dag_closure_destroy(); null if an error occurred.
+ */
+struct DagClosure *dag_closure_build(struct Dag *d, int first_id, int n_ids,
+                                     bool ancestors);
+
+/**
+ * Gets the set of target vertices that can be reached from a vertex. Bit i
+ * stands for the vertex with id first_id + i, as given to 
+ * dag_closure_build(), and a vertex does not reach itself.
+ * return - the bitset, owned by the closure; null if v is not in the graph,
+ *          or the graph has been modified.
+ */
+const uint64_t *dag_descendants(struct DagClosure *c, struct Vertex *v);
+
+/**
+ * Gets the set of target vertices that can reach a vertex, laid out as by
+ * dag_descendants().
+ * return - the bitset, owned by the closure; null if v is not in the graph,
+ *          the ancestor sets were not built, or the graph has been modified.
+ */
+const uint64_t *dag_ancestors(struct DagClosure *c, struct Vertex *v);
+
+/**
+ * Gets the target vertices of a closure.
+ * first_id - if not null, receives the id of the first target vertex.
+ * n_ids - if not null, receives the number of target vertices.
+ */
+void dag_closure_range(struct DagClosure *c, int *first_id, int *n_ids);
+
+/**
+ * Checks if there is some path between vertex a and vertex b in O(1), by
+ * looking up b in the descendant set of a.
+ * return - 1 if connected; 0 if not connected; -1 if b is not a target 
+ *          vertex of the closure, or the graph has been modified.
+ */
+int dag_closure_reaches(struct DagClosure *c, struct Vertex *a,
+                        struct Vertex *b);
+
+/**
+ * Gets the number of bytes used by a closure.
+ */
+size_t dag_closure_memory(struct DagClosure *c);
+
+/**
+ * Frees a closure built by dag_closure_build().
+ */
+void dag_closure_destroy(struct DagClosure *c);
+
+/**
+ * Sets how dag_add_edge() treats an edge from a to b when the graph already
+ * has an edge from a to b. The default is DUPLICATES_ALLOW. Duplicates are
+ * detected in O(1) expected time using the dags edge hash index.
+ * d - the dag to configure.
+ * mode - DUPLICATES_ALLOW, DUPLICATES_REJECT or DUPLICATES_MERGE.
+ */
+void dag_set_duplicate_edges(struct Dag *d, enum DuplicateEdges mode);
+
 /**
  * Gets the weight of the given vertex.
  * return - the weight of the given vertex.
@@ -54,9 +374,91 @@ void *dag_v_get_weight(struct Vertex *v);
  */
 int dag_v_get_id(struct Vertex *v);
 
+/**
+ * Gets the number of vertices in the graph. Vertex ids range from 0 up to,
+ * but not including, this number. Removed vertices are counted until
+ * dag_compact().
+ * return - the number of vertices.
+ */
+int dag_get_vertex_count(struct Dag *d);
+
+/**
+ * Gets the vertex with the given id.
+ * return - the vertex; null if there is no vertex with that id, or it has
+ *          been removed.
+ */
+struct Vertex *dag_get_vertex(struct Dag *d, int id);
+
+/**
+ * Gets the position of the given vertex in a topological order of the graph,
+ * which is kept up to date as edges are added. If rank(a) < rank(b) there is
+ * no path from b to a, so an edge from a to b can not create a cycle. Ranks
+ * are distinct but may change whenever an edge is added.
+ * return - the topological rank of v.
+ */
+int dag_v_get_topo_rank(struct Vertex *v);
+
+/**
+ * Gets the number of edges leaving the given vertex.
+ * return - the out-degree of v.
+ */
+int dag_v_get_out_degree(struct Vertex *v);
+
+/**
+ * Gets the number of edges entering the given vertex.
+ * return - the in-degree of v.
+ */
+int dag_v_get_in_degree(struct Vertex *v);
+
+/**
+ * Gets the i:th outgoing edge of the given vertex, 0 <= i < out-degree.
+ * return - the edge; null if i is out of range.
+ */
+struct Edge *dag_v_get_out_edge(struct Vertex *v, int i);
+
+/**
+ * Gets the i:th incoming edge of the given vertex, 0 <= i < in-degree.
+ * return - the edge; null if i is out of range.
+ */
+struct Edge *dag_v_get_in_edge(struct Vertex *v, int i);
+
+/**
+ * Gets the i:th successor of the given vertex, 0 <= i < out-degree.
+ * Successors are returned in the order their edges were added.
+ * return - the vertex; null if i is out of range.
+ */
+struct Vertex *dag_v_get_successor(struct Vertex *v, int i);
+
+/**
+ * Gets the i:th predecessor of the given vertex, 0 <= i < in-degree.
+ * Predecessors are returned in the order their edges were added.
+ * return - the vertex; null if i is out of range.
+ */
+struct Vertex *dag_v_get_predecessor(struct Vertex *v, int i);
+
+/**
+ * Gets the start vertex of the given edge.
+ * return - the vertex the edge leaves.
+ */
+struct Vertex *dag_e_get_from(struct Edge *e);
+
+/**
+ * Gets the destination vertex of the given edge.
+ * return - the vertex the edge enters.
+ */
+struct Vertex *dag_e_get_to(struct Edge *e);
+
+/**
+ * Gets the weight of the given edge.
+ * return - the weight of the edge.
+ */
+void *dag_e_get_weight(struct Edge *e);
+
 /**
  * Searches for an edge between vertex a and vertex b, and returns if it 
- * exists.
+ * exists. Edges are looked up in a hash index, in O(1) expected time. If
+ * there are parallel edges, the first one added is returned, or one of the
+ * others once it has been removed.
  * d - dag containing a and b.
  * a - start vertex.
  * b - destination vertex.
@@ -74,6 +476,67 @@ struct Edge *dag_find_edge(struct Dag *d, struct Vertex *a, struct Vertex *b);
  */
 int dag_is_connected(struct Dag *d, struct Vertex *a, struct Vertex *b);
 
+/**
+ * Checks if there is some path between vertex a and vertex b. Each vertex is
+ * visited at most once, using a visited bitset and frontier buffers that are
+ * kept by the dag and reused between calls.
+ * d - graph containing the vertices
+ * a - starting vertex
+ * b - destination vertex
+ * mode - SEARCH_FORWARD searches from a only. SEARCH_BIDIRECTIONAL searches
+ *        forwards from a and backwards from b, stopping when they meet.
+ * returns: 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+int dag_reachable(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                  enum SearchMode mode);
+
+/**
+ * Builds a reachability index for the graph in O(V + E) time. While the 
+ * graph is unchanged, dag_is_connected() answers most queries in constant
+ * time from the index and falls back to a pruned search for the rest. Adding
+ * a vertex or an edge invalidates the index, and dag_is_connected() then
+ * searches the graph until the index is built again.
+ * d - graph to index.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+int dag_reach_index_build(struct Dag *d);
+
+/**
+ * Frees the reachability index of the graph, if it has one. It is also
+ * freed by dag_destroy().
+ * d - graph owning the index.
+ */
+void dag_reach_index_destroy(struct Dag *d);
+
+/**
+ * Checks whether the graph has a reachability index that is up to date.
+ * return - true if the index is used by dag_is_connected(); false otherwise.
+ */
+bool dag_reach_index_is_valid(struct Dag *d);
+
+/**
+ * Gets the memory footprint of the reachability index of the graph.
+ * return - the size of the index in bytes; 0 if there is no index.
+ */
+size_t dag_reach_index_memory(struct Dag *d);
+
+/**
+ * Enumerates the paths from a to b without storing them, calling visit for
+ * each one. The search keeps a single path stack, so memory use grows with
+ * the length of the paths rather than their number.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * visit - called with the vertices of each path, from a to b, and their
+ *         number. The array is reused and only valid during the call.
+ *         Returning non-zero stops the enumeration.
+ * ctx - passed on to visit.
+ * return - 0 if all paths were visited; 1 if visit stopped the enumeration;
+ *          -1 if an error occurred.
+ */
+int dag_foreach_path(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                     path_visit_func visit, void *ctx);
+
 /**
  * Traverses the graph and creates a list of paths between the vertices 
  * that is then returned.
@@ -101,13 +564,501 @@ void *dag_weight_of_longest_path(struct Dag *d,
                                 get_weight_func f, get_weight_func g);
 
 /**
- * Performs a topological ordering, using Kahn's algorithm.
+ * Computes the longest path between the vertices a and b in O(V + E) time,
+ * by dynamic programming over the vertices reachable from a in topological
+ * order. The weight of a path is the sum of its vertex and edge weights.
+ * d - graph containing the vertices and edges.
+ * a - Path start
+ * b - Path end
+ * f - function for interpreting the weight of the vertices
+ * g - function for interpreting the weight of the edges.
+ * path - if not null, set to a list of the vertices on the longest path, from
+ *        a to b. The list must be freed with dag_destroy_path().
+ * return - the weight of the longest path between a and b, which must be 
+ *          freed by the caller. NULL is returned if b can not be reached from
+ *          a, if f or g are NULL, or if `add` and `compare` are not defined.
+ */
+void *dag_longest_path(struct Dag *d, struct Vertex *a, struct Vertex *b,
+                       get_weight_func f, get_weight_func g,
+                       struct list **path);
+
+/**
+ * Computes the weight of the longest path from a to every vertex in a single
+ * sweep over topological order, in O(V + E) time. The weight of a path is 
+ * the sum of its vertex and edge weights.
+ * d - graph containing the vertices and edges.
+ * a - Path start
+ * f - function for interpreting the weight of the vertices
+ * g - function for interpreting the weight of the edges.
+ * dist - array of dag_get_vertex_count(d) elements, indexed by vertex id,
+ *        receiving the weight of the longest path from a. The weights must be
+ *        freed by the caller. Vertices that can not be reached get null.
+ * pred - if not null, array of dag_get_vertex_count(d) elements receiving the
+ *        last edge of the path to each vertex; null for a and for vertices 
+ *        that can not be reached. Following dag_e_get_from() back from a
+ *        vertex yields its path in reverse.
+ * return - 0 on success; -1 if an error occurred, or if f or g are NULL, or
+ *          `add` and `compare` are not defined.
+ */
+int dag_longest_paths_from(struct Dag *d, struct Vertex *a,
+                           get_weight_func f, get_weight_func g,
+                           void **dist, struct Edge **pred);
+
+/**
+ * Computes the weight of the shortest path from a to every vertex in a single
+ * sweep over topological order. The arguments are the same as for 
+ * dag_longest_paths_from().
+ */
+int dag_shortest_paths_from(struct Dag *d, struct Vertex *a,
+                            get_weight_func f, get_weight_func g,
+                            void **dist, struct Edge **pred);
+
+/**
+ * Computes the weight of the longest path from any of the sources to every
+ * vertex in a single sweep over topological order. The arguments are the same
+ * as for dag_longest_paths_from(), with a replaced by n_sources vertices.
+ * pred is null for a source unless a longer path from another source leads
+ * to it.
+ */
+int dag_longest_paths_from_sources(struct Dag *d, struct Vertex **sources,
+                                   int n_sources, get_weight_func f, 
+                                   get_weight_func g, void **dist, 
+                                   struct Edge **pred);
+
+/**
+ * Computes the weight of the shortest path from any of the sources to every
+ * vertex in a single sweep over topological order. See 
+ * dag_longest_paths_from_sources().
+ */
+int dag_shortest_paths_from_sources(struct Dag *d, struct Vertex **sources,
+                                    int n_sources, get_weight_func f, 
+                                    get_weight_func g, void **dist, 
+                                    struct Edge **pred);
+
+/**
+ * Counts the paths from a to b without enumerating them, by a single pass
+ * over topological order in O(V + E) time.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * return - the number of paths; UINT64_MAX if there are at least that many.
+ *          0 is also returned if an error occurred.
+ */
+uint64_t dag_count_paths(struct Dag *d, struct Vertex *a, struct Vertex *b);
+
+/**
+ * Counts the paths from a to every vertex in O(V + E) time. Counts saturate
+ * at UINT64_MAX.
+ * d - dag containing the vertex a.
+ * a - Starting vertex
+ * counts - array of dag_get_vertex_count(d) elements, indexed by vertex id,
+ *          receiving the number of paths from a. Vertices that can not be
+ *          reached get 0, and a itself 1.
+ * return - 0 on success; -1 if an error occurred.
+ */
+int dag_count_paths_from(struct Dag *d, struct Vertex *a, uint64_t *counts);
+
+/**
+ * Counts the paths from a to b exactly, for graphs with more paths than fit
+ * in 64 bits. Runs in O((V + E) * L) time, L being the length of the result.
+ * d - dag containing the vertices a and b.
+ * a - Starting vertex
+ * b - Goal vertex
+ * return - the number of paths as a decimal string, which must be freed by
+ *          the caller; null if an error occurred.
+ */
+char *dag_count_paths_big(struct Dag *d, struct Vertex *a, struct Vertex *b);
+
+/**
+ * Orders the vertices topologically, using Kahn's algorithm. The graph is 
+ * not modified, and the order is cached until the graph is, so repeated
+ * calls on an unchanged graph are O(1).
+ * d - graph containing the vertices to sort.
+ * n - if not null, receives the number of vertices, not counting removed
+ *     ones.
+ * return - the vertices in topological order. The array is owned by the
+ *          graph and valid until it is modified; null if an error occurred.
+ */
+struct Vertex **dag_topological_order(struct Dag *d, int *n);
+
+/**
+ * Performs a topological ordering, using Kahn's algorithm. The order is
+ * copied from the one cached by dag_topological_order().
  * dag - graph containing the vertices to sort.
  * return - A list containing the sorted elements. This list must be 
  *          freed by calling dag_destroy_path() to avoid memory leaks.
  */
 struct list *dag_topological_ordering(struct Dag *d);
 
+/**
+ * Partitions the vertices of the graph into topological levels: the first
+ * level holds the vertices without incoming edges, and every other level the
+ * vertices whose predecessors are all in earlier levels, with at least one
+ * in the level just before. Each level is expanded in parallel by a pool of
+ * threads that decrement in-degrees atomically. The order of the vertices
+ * within a level is unspecified. The graph must not be modified meanwhile.
+ * d - graph to order.
+ * n_threads - number of threads to use, including the calling thread. If
+ *             fewer threads can be started, the ones that were are used.
+ * return - the levels, to be freed with dag_topological_levels_destroy();
+ *          null if an error occurred.
+ */
+struct TopoLevels *dag_topological_levels(struct Dag *d, int n_threads);
+
+/**
+ * Frees the levels returned by dag_topological_levels().
+ * levels - the levels to free.
+ */
+void dag_topological_levels_destroy(struct TopoLevels *levels);
+
+/**
+ * Runs a task for every vertex of the graph on a pool of threads. A task is
+ * started once the tasks of all predecessors of its vertex have finished.
+ * Every thread keeps the tasks it released in a work-stealing deque, and
+ * steals from the other threads when its own deque is empty.
+ * d - graph whose vertices to run. It must not be modified meanwhile.
+ * task - called once for each vertex, on any of the threads. Returning 
+ *        non-zero stops the execution once the running tasks have finished.
+ * ctx - passed on to task.
+ * n_threads - number of threads to use, including the calling thread. If
+ *             fewer threads can be started, the ones that were are used.
+ * task_seconds - if not null, receives the wall time of the task of each
+ *                vertex, indexed by vertex id.
+ * total_seconds - if not null, receives the wall time of the execution.
+ * return - 0 if every task has run; 1 if a task stopped the execution; 
+ *          -1 if an error occurred.
+ */
+int dag_execute(struct Dag *d, task_func task, void *ctx, int n_threads,
+                double *task_seconds, double *total_seconds);
+
+/**
+ * Creates a builder for staging a graph from several threads at once. Every
+ * thread stages vertices and edges in a handle of its own, without locks,
+ * and dag_builder_finish() merges them into a graph.
+ * add_func, comp_func, mode - passed on to dag_create_with_alloc().
+ * n_threads - number of handles.
+ * return - the builder, to be freed with dag_builder_destroy(); null if an
+ *          error occurred.
+ */
+struct DagBuilder *dag_builder_create(add_weight_func add_func,
+                                      weight_comp_func comp_func,
+                                      enum AllocMode mode, int n_threads);
+
+/**
+ * Gets handle i of a builder, for use by one thread at a time.
+ * return - the handle; null if i is out of range.
+ */
+struct DagBuildHandle *dag_builder_handle(struct DagBuilder *b, int i);
+
+/**
+ * Stages a vertex with the weight w. Its staging id is taken from a block
+ * of ids reserved by the handle, so threads only synchronize once per 
+ * block. Staging ids are unique across handles, but not dense.
+ * return - the staging id of the vertex; -1 if an error occurred.
+ */
+int dag_build_add_vertex(struct DagBuildHandle *h, void *w);
+
+/**
+ * Stages an edge with the weight w between two vertices staged by any
+ * handle of the builder. The edge is not checked until the graph is built.
+ * from - staging id of the start vertex.
+ * to - staging id of the destination vertex.
+ * return - 0 on success; -1 if an error occurred.
+ */
+int dag_build_add_edge(struct DagBuildHandle *h, int from, int to, void *w);
+
+/**
+ * Builds the staged graph, once every thread has finished staging. The
+ * vertices are added in staging id order, and the edges with a single
+ * acyclicity check, as by dag_add_edges_bulk().
+ * return - the graph; null if an edge refers to an unknown vertex, the 
+ *          edges would create a cycle, or an error occurred.
+ */
+struct Dag *dag_builder_finish(struct DagBuilder *b);
+
+/**
+ * Gets the vertex built for a staging id by dag_builder_finish().
+ * return - the vertex; null if there is none.
+ */
+struct Vertex *dag_builder_vertex(struct DagBuilder *b, int id);
+
+/**
+ * Frees a builder and its handles. The built graph is not freed.
+ */
+void dag_builder_destroy(struct DagBuilder *b);
+
+/**
+ * Loads an edge list of lines "from<delim>to[<delim>weight]" into the graph.
+ * The file is read in large chunks and parsed in place. Keys are mapped to
+ * vertices through a hash table, adding a vertex for each new key with the
+ * key as its weight: a string, or an int64_t in integer mode. Weights are 
+ * parsed as int64_t; edges without one get a null weight. Empty lines and 
+ * lines starting with '#' are skipped. The edges are added with a single
+ * acyclicity check once the whole file has been parsed, as by
+ * dag_add_edges_bulk().
+ * d - graph to load the edges into.
+ * path - file to read.
+ * delim - character separating the fields, such as '\t' or ','.
+ * keys - how to interpret the vertex keys.
+ * loaded - receives the keys and weights, which must be kept until the
+ *          graph is destroyed without freeing its weights, and then freed
+ *          with dag_edge_list_destroy(). It is also set on failure, as 
+ *          vertices may have been added.
+ * res - if not null, receives the statistics of the load, including the
+ *       line that failed.
+ * return - 0 if all edges were added; -1 if none were, because a line could
+ *          not be parsed, the edges would create a cycle, or an error 
+ *          occurred.
+ */
+int dag_load_edge_list(struct Dag *d, const char *path, char delim,
+                       enum LoadKeys keys, struct EdgeList **loaded,
+                       struct LoadResult *res);
+
+/**
+ * Finds the vertex loaded for a key by dag_load_edge_list().
+ * key - the key, as it would appear in the file.
+ * return - the vertex; null if the key was not loaded.
+ */
+struct Vertex *dag_edge_list_vertex(struct EdgeList *l, const char *key);
+
+/**
+ * Frees the keys and weights of a graph loaded by dag_load_edge_list().
+ */
+void dag_edge_list_destroy(struct EdgeList *l);
+
+/**
+ * Saves the graph to a file that dag_open_mmap() can map. The vertex and
+ * edge tables are stored in compressed sparse row layout, along with a 
+ * topological order. Vertices keep their ids, with removed vertices stored
+ * as isolated vertices without weights, and edges are numbered by 
+ * source vertex id, in the order of dag_v_get_out_edge(). The file uses the
+ * byte order of the machine writing it.
+ * d - graph to save.
+ * path - file to write.
+ * v_weight_size - if non-zero, vertex weights are stored inline, by copying
+ *                 this many bytes from each weight pointer. Suits numeric
+ *                 weights. Null weights are stored as zeros.
+ * e_weight_size - the same, for edge weights.
+ * v_bytes - if v_weight_size is zero and this is not null, serializes each
+ *           vertex weight. Otherwise vertex weights are not stored.
+ * e_bytes - the same, for edge weights.
+ * return - 0 on success; -1 if an error occurred.
+ */
+int dag_save(struct Dag *d, const char *path,
+             size_t v_weight_size, size_t e_weight_size,
+             weight_bytes_func v_bytes, weight_bytes_func e_bytes);
+
+/**
+ * Maps a file written by dag_save() as a read-only graph. Only the header is
+ * read up front, and every section it describes is checked to lie within 
+ * the file; the tables are used in place, so pages are loaded as they are
+ * first touched. The offsets and ids in the tables are trusted: a file that
+ * did not come from dag_save() should be checked with dag_snapshot_verify()
+ * before use. The file must not be modified while it is mapped.
+ * path - file to map.
+ * return - the graph, to be closed with dag_snapshot_close(); null if the 
+ *          file could not be mapped, is not a snapshot, or is truncated.
+ */
+struct DagSnapshot *dag_open_mmap(const char *path);
+
+/**
+ * Checks that every offset and vertex or edge id stored in a mapped graph
+ * is in range, so that no accessor can read outside the file. Reads the
+ * whole file.
+ * return - 0 if the graph is consistent; -1 otherwise.
+ */
+int dag_snapshot_verify(struct DagSnapshot *s);
+
+/**
+ * Unmaps a graph opened by dag_open_mmap(). Pointers obtained from it are
+ * no longer valid afterwards.
+ */
+void dag_snapshot_close(struct DagSnapshot *s);
+
+/**
+ * Gets the number of vertices in a mapped graph.
+ * return - the number of vertices.
+ */
+int dag_snapshot_vertex_count(struct DagSnapshot *s);
+
+/**
+ * Gets the number of edges in a mapped graph.
+ * return - the number of edges.
+ */
+int dag_snapshot_edge_count(struct DagSnapshot *s);
+
+/**
+ * Gets the successors of a vertex in a mapped graph.
+ * id - id of the vertex.
+ * n - receives the number of successors.
+ * first - if not null, receives the index of the edge to the first 
+ *         successor. The edges to the others follow in the same order.
+ * return - the ids of the successors.
+ */
+const int32_t *dag_snapshot_successors(struct DagSnapshot *s, int id,
+                                       int *n, int *first);
+
+/**
+ * Gets the predecessors of a vertex in a mapped graph.
+ * id - id of the vertex.
+ * n - receives the number of predecessors.
+ * edges - if not null, receives the indices of the edges from the 
+ *         predecessors, in the same order.
+ * return - the ids of the predecessors.
+ */
+const int32_t *dag_snapshot_predecessors(struct DagSnapshot *s, int id,
+                                         int *n, const int32_t **edges);
+
+/**
+ * Gets the target vertex of an edge in a mapped graph.
+ * return - the id of the target vertex.
+ */
+int dag_snapshot_e_get_to(struct DagSnapshot *s, int e);
+
+/**
+ * Gets the topological order stored with a mapped graph.
+ * n - if not null, receives the number of vertices.
+ * return - the vertex ids in topological order.
+ */
+const int32_t *dag_snapshot_topological_order(struct DagSnapshot *s, int *n);
+
+/**
+ * Gets the weight of a vertex in a mapped graph. Inline weights are aligned
+ * as far as their size allows, serialized weights are not aligned.
+ * id - id of the vertex.
+ * len - if not null, receives the size of the weight in bytes.
+ * return - the stored weight; null if the graph has no vertex weights.
+ */
+const void *dag_snapshot_v_get_weight(struct DagSnapshot *s, int id, 
+                                      size_t *len);
+
+/**
+ * Gets the weight of an edge in a mapped graph.
+ * e - index of the edge.
+ * len - if not null, receives the size of the weight in bytes.
+ * return - the stored weight; null if the graph has no edge weights.
+ */
+const void *dag_snapshot_e_get_weight(struct DagSnapshot *s, int e, 
+                                      size_t *len);
+
+/**
+ * Shares a graph between writers and concurrent readers with snapshot 
+ * isolation. Readers never see the graph itself, only immutable views of it
+ * that are published after each batch of changes. A read section holds one
+ * view for its duration, without locks and without blocking the writer.
+ * Replaced views are freed once every read section that could hold them has
+ * ended, using epoch based reclamation. Publishing copies the graph in 
+ * O(V + E) time, so changes should be batched.
+ * d - graph to share. From now on it must only be accessed between
+ *     dag_shared_write_begin() and dag_shared_write_end().
+ * max_readers - number of reader slots.
+ * return - the shared graph, to be freed with dag_shared_destroy(); null if
+ *          an error occurred.
+ */
+struct DagShared *dag_shared_create(struct Dag *d, int max_readers);
+
+/**
+ * Frees a shared graph and its views, once no reader is left inside a read
+ * section. The graph itself is not freed.
+ */
+void dag_shared_destroy(struct DagShared *s);
+
+/**
+ * Starts a batch of changes to a shared graph, waiting for any other writer
+ * to finish its batch.
+ * return - the graph, to be changed with the usual functions.
+ */
+struct Dag *dag_shared_write_begin(struct DagShared *s);
+
+/**
+ * Ends a batch of changes, publishing a new view to readers if the graph
+ * was modified. Read sections started before keep their view.
+ * return - 0 on success; -1 if the view could not be built, in which case
+ *          the readers keep the previous one.
+ */
+int dag_shared_write_end(struct DagShared *s);
+
+/**
+ * Claims a reader slot for the calling thread. A reader must only be used by
+ * one thread at a time.
+ * return - the reader; null if all slots are taken.
+ */
+struct DagReader *dag_reader_register(struct DagShared *s);
+
+/**
+ * Releases a reader slot claimed by dag_reader_register().
+ */
+void dag_reader_unregister(struct DagReader *r);
+
+/**
+ * Starts a read section, without locking.
+ * return - the latest published view, valid until dag_read_end().
+ */
+const struct DagView *dag_read_begin(struct DagReader *r);
+
+/**
+ * Ends a read section. The view it returned must no longer be used.
+ */
+void dag_read_end(struct DagReader *r);
+
+/**
+ * Gets the version of the graph that a view was published at, which grows
+ * with every change to the graph.
+ */
+uint64_t dag_view_version(const struct DagView *view);
+
+/**
+ * Gets the number of vertices in a view.
+ */
+int dag_view_vertex_count(const struct DagView *view);
+
+/**
+ * Gets the number of edges in a view.
+ */
+int dag_view_edge_count(const struct DagView *view);
+
+/**
+ * Returns the ids of the successors of a vertex in a view.
+ * id - id of the vertex.
+ * n - receives the number of successors.
+ */
+const int32_t *dag_view_successors(const struct DagView *view, int id,
+                                   int *n);
+
+/**
+ * Gets a topological order of the vertices of a view.
+ * n - if not null, receives the number of vertices.
+ * return - the ids of the vertices in topological order.
+ */
+const int32_t *dag_view_topological_order(const struct DagView *view, int *n);
+
+/**
+ * Checks if there is some path between two vertices, in the view of the 
+ * current read section of a reader. The search uses scratch space kept by
+ * the reader, so readers do not share any writable memory.
+ * r - reader inside a read section.
+ * a - id of the starting vertex.
+ * b - id of the destination vertex.
+ * return - 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+int dag_view_is_connected(struct DagReader *r, int a, int b);
+
+/**
+ * Gets the operation counters of the graph, collected since it was created
+ * or since the last dag_stats_reset(). Counting is compiled in only when
+ * DAG_STATS is defined, and costs nothing otherwise.
+ * d - graph to get the counters of.
+ * stats - receives the counters; zeroed if they are not collected.
+ * return - 0 on success; -1 if the library was compiled without DAG_STATS.
+ */
+int dag_stats_get(struct Dag *d, struct DagStats *stats);
+
+/**
+ * Resets the operation counters of the graph to zero. bytes_live is not
+ * reset, as it describes the current state of the graph.
+ */
+void dag_stats_reset(struct Dag *d);
+
 /**
  * Cleans up dynamically allocated resources. This will destroy the graph,
  * vertices and edges.
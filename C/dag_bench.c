@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "dag.h"
+
+/*
+ * Benchmarks the dag on synthetic graphs. Every measurement is printed as
+ * one tab separated line:
+ *
+ *   generator  vertices  edges  operation  count  seconds  ns_per_op
+ *
+ * preceded by a header line, so that runs of different commits can be
+ * compared with standard tools. Usage: dag_bench [max_vertices]
+ */
+
+// Queries made per graph by the query benchmarks.
+#define BENCH_QUERIES 1000
+// Graphs with more paths than this are not enumerated.
+#define BENCH_MAX_PATHS 100000
+
+// A generated graph, as an edge list over vertices 0 to n - 1. The sink
+// can be reached from the source.
+struct BenchGraph {
+    const char *name;
+    int n;
+    int source;
+    int sink;
+    int m;
+    int cap;
+    int *from;
+    int *to;
+};
+
+static uint64_t bench_rand_state = 88172645463325252ull;
+
+// xorshift64, seeded with a constant so every run builds the same graphs.
+static uint64_t bench_rand(void) {
+    bench_rand_state ^= bench_rand_state << 13;
+    bench_rand_state ^= bench_rand_state >> 7;
+    bench_rand_state ^= bench_rand_state << 17;
+    return bench_rand_state;
+}
+
+static int bench_rand_below(int n) {
+    return (int) (bench_rand() % (uint64_t) n);
+}
+
+static double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static enum WeightComp bench_compare(void *a_v, void *b_v) {
+    int64_t a = *(int64_t *) a_v;
+    int64_t b = *(int64_t *) b_v;
+    if (a > b) return GREATER_THAN;
+    if (a < b) return LESS_THAN;
+
+    return EQUAL;
+}
+
+static void *bench_add(void *a_v, void *b_v) {
+    int64_t *res = malloc(sizeof(*res));
+    *res = (a_v ? *(int64_t *) a_v : 0) + *(int64_t *) b_v;
+    return res;
+}
+
+static void *bench_get(void *a_v) {
+    return a_v;
+}
+
+static void bench_add_edge(struct BenchGraph *g, int a, int b) {
+    if (g->m == g->cap) {
+        g->cap = g->cap ? 2 * g->cap : 1024;
+        g->from = realloc(g->from, g->cap * sizeof(*g->from));
+        g->to = realloc(g->to, g->cap * sizeof(*g->to));
+        if (!g->from || !g->to) {
+            fprintf(stderr, "dag_bench: out of memory\n");
+            exit(1);
+        }
+    }
+    g->from[g->m] = a;
+    g->to[g->m] = b;
+    g->m++;
+}
+
+static struct BenchGraph bench_graph(const char *name, int n) {
+    struct BenchGraph g = {name, n, 0, n - 1, 0, 0, NULL, NULL};
+    return g;
+}
+
+/**
+ * Generates layers of width vertices, where every vertex has edges from the
+ * vertex right above it and from fan_in - 1 random vertices of the layer
+ * above.
+ */
+static struct BenchGraph bench_layered(int n, int width, int fan_in) {
+    struct BenchGraph g = bench_graph("layered", n);
+    g.source = (n - 1) % width;
+    for (int v = width; v < n; v++) {
+        int layer_start = v - v % width - width;
+        bench_add_edge(&g, v - width, v);
+        for (int i = 1; i < fan_in; i++) {
+            bench_add_edge(&g, layer_start + bench_rand_below(width), v);
+        }
+    }
+    return g;
+}
+
+/**
+ * Generates the chain 0 -> 1 -> ... -> n - 1.
+ */
+static struct BenchGraph bench_chain(int n) {
+    struct BenchGraph g = bench_graph("chain", n);
+    for (int v = 1; v < n; v++) {
+        bench_add_edge(&g, v - 1, v);
+    }
+    return g;
+}
+
+/**
+ * Generates a sequence of diamonds, each a vertex joined to the next one
+ * through width vertices in between. The number of paths through the
+ * sequence grows as width to the power of the number of diamonds.
+ */
+static struct BenchGraph bench_diamonds(int n, int width) {
+    struct BenchGraph g = bench_graph("diamonds", n);
+    int top = 0;
+    while (top + width + 1 < n) {
+        int bottom = top + width + 1;
+        for (int i = 1; i <= width; i++) {
+            bench_add_edge(&g, top, top + i);
+            bench_add_edge(&g, top + i, bottom);
+        }
+        top = bottom;
+    }
+    // Connect any leftover vertices as a chain.
+    for (int v = top + 1; v < n; v++) {
+        bench_add_edge(&g, v - 1, v);
+    }
+    return g;
+}
+
+/**
+ * Generates edges from each vertex to random later vertices, with out-degrees
+ * following a power law: about n / k^2 vertices have out-degree k.
+ */
+static struct BenchGraph bench_power_law(int n) {
+    struct BenchGraph g = bench_graph("power_law", n);
+    for (int v = 0; v < n - 1; v++) {
+        // Inverse transform sampling of P(k) ~ 1 / k^2.
+        double u = (bench_rand() >> 11) * (1.0 / 9007199254740992.0);
+        int degree = (int) (1.0 / (1.0 - u));
+        if (degree > 1000) degree = 1000;
+
+        int later = n - v - 1;
+        for (int i = 0; i < degree; i++) {
+            bench_add_edge(&g, v, v + 1 + bench_rand_below(later));
+        }
+    }
+    bench_add_edge(&g, 0, n - 1);
+    return g;
+}
+
+static void bench_report(struct BenchGraph *g, const char *op, long count,
+                         double seconds) {
+    printf("%s\t%d\t%d\t%s\t%ld\t%.6f\t%.1f\n", g->name, g->n, g->m, op,
+           count, seconds, count > 0 ? seconds * 1e9 / count : 0.0);
+    fflush(stdout);
+}
+
+/**
+ * Builds the graph with dag_add_edge() in a shuffled order, so that the
+ * topological order has to be repaired along the way, and runs the query
+ * benchmarks on it.
+ */
+static void bench_run(struct BenchGraph *g) {
+    static int64_t one = 1;
+
+    struct Dag *d = dag_create(bench_add, bench_compare);
+    struct Vertex **v = malloc(g->n * sizeof(*v));
+    int *order = malloc((g->m + 1) * sizeof(*order));
+    if (!d || !v || !order) {
+        fprintf(stderr, "dag_bench: out of memory\n");
+        exit(1);
+    }
+
+    double start = bench_now();
+    for (int i = 0; i < g->n; i++) {
+        v[i] = dag_add_vertex(d, &one);
+    }
+    bench_report(g, "dag_add_vertex", g->n, bench_now() - start);
+
+    for (int i = 0; i < g->m; i++) {
+        order[i] = i;
+    }
+    for (int i = g->m - 1; i > 0; i--) {
+        int j = bench_rand_below(i + 1);
+        int t = order[i];
+        order[i] = order[j];
+        order[j] = t;
+    }
+
+    start = bench_now();
+    for (int i = 0; i < g->m; i++) {
+        int e = order[i];
+        if (dag_add_edge(d, v[g->from[e]], v[g->to[e]], &one) != 0) {
+            fprintf(stderr, "dag_bench: could not add edge\n");
+            exit(1);
+        }
+    }
+    bench_report(g, "dag_add_edge", g->m, bench_now() - start);
+
+    start = bench_now();
+    int connected = 0;
+    for (int i = 0; i < BENCH_QUERIES; i++) {
+        int a = bench_rand_below(g->n);
+        int b = bench_rand_below(g->n);
+        connected += dag_is_connected(d, v[a], v[b]) == 1;
+    }
+    bench_report(g, "dag_is_connected", BENCH_QUERIES, bench_now() - start);
+
+    start = bench_now();
+    struct list *sorted = dag_topological_ordering(d);
+    bench_report(g, "dag_topological_ordering", 1, bench_now() - start);
+    dag_destroy_path(sorted);
+
+    struct Vertex *source = v[g->source];
+    start = bench_now();
+    int64_t *w = dag_weight_of_longest_path(d, source, v[g->sink],
+                                            bench_get, bench_get);
+    bench_report(g, "dag_weight_of_longest_path", 1, bench_now() - start);
+    free(w);
+
+    // Most graphs have far too many paths to the sink to list, so the paths
+    // are listed to the vertex with the most paths from the source that are
+    // still few enough. Ties go to the higher id, which is further from the
+    // source, since ids grow along the paths of every graph.
+    uint64_t *counts = malloc(g->n * sizeof(*counts));
+    if (counts == NULL || dag_count_paths_from(d, source, counts) != 0) {
+        fprintf(stderr, "dag_bench: could not count paths\n");
+        exit(1);
+    }
+    int target = -1;
+    uint64_t paths = 0;
+    for (int i = 0; i < g->n; i++) {
+        if (i != g->source && counts[i] >= paths && counts[i] > 0
+                && counts[i] <= BENCH_MAX_PATHS) {
+            target = i;
+            paths = counts[i];
+        }
+    }
+    free(counts);
+    if (target >= 0) {
+        start = bench_now();
+        struct list *all = dag_get_all_paths(d, source, v[target]);
+        bench_report(g, "dag_get_all_paths", (long) paths,
+                     bench_now() - start);
+        dag_all_paths_list_destroy(all);
+    }
+
+    dag_destroy(d, false);
+    free(v);
+    free(order);
+    free(g->from);
+    free(g->to);
+}
+
+int main(int argc, char **argv) {
+    int max_vertices = argc > 1 ? atoi(argv[1]) : 1000000;
+    if (max_vertices < 10) {
+        fprintf(stderr, "usage: %s [max_vertices >= 10]\n", argv[0]);
+        return 1;
+    }
+
+    printf("generator\tvertices\tedges\toperation\tcount\tseconds\tns_per_op\n");
+    for (int n = 1000; n <= max_vertices; n *= 10) {
+        struct BenchGraph g = bench_layered(n, 100, 3);
+        bench_run(&g);
+
+        g = bench_chain(n);
+        bench_run(&g);
+
+        g = bench_diamonds(n, 8);
+        bench_run(&g);
+
+        g = bench_power_law(n);
+        bench_run(&g);
+    }
+
+    return 0;
+}
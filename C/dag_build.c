@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+// Number of vertex ids a thread reserves at a time.
+#define BUILD_BLOCK_SIZE 4096
+
+/*
+ * The staging area of one thread. Its i:th vertex has the id
+ * blocks[i / BUILD_BLOCK_SIZE] * BUILD_BLOCK_SIZE + i % BUILD_BLOCK_SIZE.
+ * Edges refer to vertices by these ids, which may belong to other threads.
+ */
+struct DagBuildHandle {
+    struct DagBuilder *b;
+    int *blocks;
+    int n_blocks;
+    int blocks_cap;
+    void **v_weights;
+    int n_vertices;
+    int v_cap;
+    int *e_from;
+    int *e_to;
+    void **e_weights;
+    int n_edges;
+    int e_cap;
+};
+
+struct DagBuilder {
+    add_weight_func add;
+    weight_comp_func comp;
+    enum AllocMode mode;
+    atomic_int next_block;
+    int n_handles;
+    struct DagBuildHandle *handles;
+    // Filled in by dag_builder_finish(): the vertex with each staging id.
+    struct Vertex **vertices;
+    int n_ids;
+};
+
+/**
+ * Grows an array of elements of size bytes to hold at least need elements.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int build_grow(void **array, int *cap, int need, size_t size) {
+    if (*cap >= need) return 0;
+
+    int new_cap = *cap == 0 ? 256 : *cap;
+    while (new_cap < need) {
+        new_cap *= 2;
+    }
+    void *tmp = realloc(*array, new_cap * size);
+    if (tmp == NULL) return -1;
+
+    *array = tmp;
+    *cap = new_cap;
+    return 0;
+}
+
+/**
+ * Creates a builder with one staging handle per thread.
+ * return - the builder; null if an error occurred.
+ */
+struct DagBuilder *dag_builder_create(add_weight_func add_func,
+                                      weight_comp_func comp_func,
+                                      enum AllocMode mode, int n_threads) {
+    if (n_threads < 1) return NULL;
+
+    struct DagBuilder *b = malloc(sizeof(*b));
+    struct DagBuildHandle *handles = calloc(n_threads, sizeof(*handles));
+    if (!b || !handles) {
+        free(b);
+        free(handles);
+        return NULL;
+    }
+
+    b->add = add_func;
+    b->comp = comp_func;
+    b->mode = mode;
+    atomic_init(&b->next_block, 0);
+    b->n_handles = n_threads;
+    b->handles = handles;
+    b->vertices = NULL;
+    b->n_ids = 0;
+    for (int i = 0; i < n_threads; i++) {
+        handles[i].b = b;
+    }
+
+    return b;
+}
+
+/**
+ * Gets the staging handle of thread i.
+ */
+struct DagBuildHandle *dag_builder_handle(struct DagBuilder *b, int i) {
+    if (!b || i < 0 || i >= b->n_handles) return NULL;
+
+    return &b->handles[i];
+}
+
+/**
+ * Stages a vertex. Ids are handed out from blocks reserved with a single
+ * atomic add, so threads only contend once per block.
+ * return - the staging id of the vertex; -1 if an error occurred.
+ */
+int dag_build_add_vertex(struct DagBuildHandle *h, void *w) {
+    int offset = h->n_vertices % BUILD_BLOCK_SIZE;
+    if (offset == 0) {
+        if (build_grow((void **) &h->blocks, &h->blocks_cap, h->n_blocks + 1,
+                       sizeof(*h->blocks)) < 0) {
+            return -1;
+        }
+        int block = atomic_fetch_add(&h->b->next_block, 1);
+        if (block >= INT32_MAX / BUILD_BLOCK_SIZE) return -1;
+        h->blocks[h->n_blocks++] = block;
+    }
+    if (build_grow((void **) &h->v_weights, &h->v_cap, h->n_vertices + 1,
+                   sizeof(*h->v_weights)) < 0) {
+        return -1;
+    }
+
+    h->v_weights[h->n_vertices++] = w;
+    return h->blocks[h->n_blocks - 1] * BUILD_BLOCK_SIZE + offset;
+}
+
+/**
+ * Stages an edge between two staged vertices. Nothing is checked until the
+ * graph is built.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+int dag_build_add_edge(struct DagBuildHandle *h, int from, int to, void *w) {
+    if (h->n_edges == h->e_cap) {
+        int new_cap = h->e_cap == 0 ? 256 : h->e_cap * 2;
+        int *e_from = realloc(h->e_from, new_cap * sizeof(*e_from));
+        if (e_from) h->e_from = e_from;
+        int *e_to = realloc(h->e_to, new_cap * sizeof(*e_to));
+        if (e_to) h->e_to = e_to;
+        void **e_weights = realloc(h->e_weights, new_cap * sizeof(*e_weights));
+        if (e_weights) h->e_weights = e_weights;
+        if (!e_from || !e_to || !e_weights) return -1;
+        h->e_cap = new_cap;
+    }
+
+    h->e_from[h->n_edges] = from;
+    h->e_to[h->n_edges] = to;
+    h->e_weights[h->n_edges] = w;
+    h->n_edges++;
+
+    return 0;
+}
+
+/**
+ * Merges the staging areas into a new graph. The vertices are added in
+ * staging id order, followed by all edges with a single acyclicity check.
+ * return - the graph; null if an edge refers to an unknown vertex, the
+ *          edges would create a cycle, or an error occurred.
+ */
+struct Dag *dag_builder_finish(struct DagBuilder *b) {
+    if (b == NULL || b->vertices != NULL) return NULL;
+
+    int n_blocks = atomic_load(&b->next_block);
+    int n_ids = n_blocks * BUILD_BLOCK_SIZE;
+    int n_vertices = 0;
+    int n_edges = 0;
+    for (int t = 0; t < b->n_handles; t++) {
+        n_vertices += b->handles[t].n_vertices;
+        n_edges += b->handles[t].n_edges;
+    }
+
+    struct Dag *d = dag_create_with_alloc(b->add, b->comp, b->mode);
+    struct Vertex **vertices = calloc(n_ids + 1, sizeof(*vertices));
+    // The handle owning each block and the index of the block within it.
+    int *owner = malloc((n_blocks + 1) * sizeof(*owner));
+    int *owner_block = malloc((n_blocks + 1) * sizeof(*owner_block));
+    struct Vertex **from = malloc((n_edges + 1) * sizeof(*from));
+    struct Vertex **to = malloc((n_edges + 1) * sizeof(*to));
+    void **weights = malloc((n_edges + 1) * sizeof(*weights));
+    struct Vertex **v_array = malloc((n_vertices + 1) * sizeof(*v_array));
+    bool ok = d && vertices && owner && owner_block && from && to && weights
+              && v_array;
+
+    if (ok) {
+        // Size the vertex array up front instead of doubling it.
+        free(d->vertices);
+        d->vertices = v_array;
+        d->v_cap = n_vertices + 1;
+        v_array = NULL;
+
+        for (int i = 0; i < n_blocks; i++) {
+            owner[i] = -1;
+        }
+        for (int t = 0; t < b->n_handles; t++) {
+            for (int k = 0; k < b->handles[t].n_blocks; k++) {
+                owner[b->handles[t].blocks[k]] = t;
+                owner_block[b->handles[t].blocks[k]] = k;
+            }
+        }
+    }
+
+    for (int block = 0; ok && block < n_blocks; block++) {
+        if (owner[block] < 0) continue;
+
+        struct DagBuildHandle *h = &b->handles[owner[block]];
+        int first = owner_block[block] * BUILD_BLOCK_SIZE;
+        int count = h->n_vertices - first < BUILD_BLOCK_SIZE
+                    ? h->n_vertices - first : BUILD_BLOCK_SIZE;
+        for (int i = 0; ok && i < count; i++) {
+            struct Vertex *v = dag_add_vertex(d, h->v_weights[first + i]);
+            vertices[block * BUILD_BLOCK_SIZE + i] = v;
+            ok = v != NULL;
+        }
+    }
+
+    int m = 0;
+    for (int t = 0; ok && t < b->n_handles; t++) {
+        struct DagBuildHandle *h = &b->handles[t];
+        for (int i = 0; ok && i < h->n_edges; i++) {
+            int a = h->e_from[i];
+            int c = h->e_to[i];
+            ok = a >= 0 && a < n_ids && c >= 0 && c < n_ids
+                 && vertices[a] != NULL && vertices[c] != NULL;
+            if (ok) {
+                from[m] = vertices[a];
+                to[m] = vertices[c];
+                weights[m++] = h->e_weights[i];
+            }
+        }
+    }
+    ok = ok && dag_add_edges_bulk(d, from, to, weights, m, NULL, NULL) == 0;
+
+    free(owner);
+    free(owner_block);
+    free(from);
+    free(to);
+    free(weights);
+    free(v_array);
+    if (!ok) {
+        free(vertices);
+        if (d) dag_destroy(d, false);
+        return NULL;
+    }
+
+    b->vertices = vertices;
+    b->n_ids = n_ids;
+    return d;
+}
+
+/**
+ * Gets the vertex built for a staging id.
+ * return - the vertex; null if there is none, or the graph is not built.
+ */
+struct Vertex *dag_builder_vertex(struct DagBuilder *b, int id) {
+    if (!b || !b->vertices || id < 0 || id >= b->n_ids) return NULL;
+
+    return b->vertices[id];
+}
+
+/**
+ * Frees a builder and its staging areas. The built graph is not freed.
+ */
+void dag_builder_destroy(struct DagBuilder *b) {
+    if (b == NULL) return;
+
+    for (int t = 0; t < b->n_handles; t++) {
+        struct DagBuildHandle *h = &b->handles[t];
+        free(h->blocks);
+        free(h->v_weights);
+        free(h->e_from);
+        free(h->e_to);
+        free(h->e_weights);
+    }
+    free(b->handles);
+    free(b->vertices);
+    free(b);
+}
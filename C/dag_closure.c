@@ -0,0 +1,268 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CLOSURE_X86 1
+#endif
+
+#include "dag.h"
+#include "dag_internal.h"
+
+// Rows are padded to whole 256 bit vectors.
+#define CLOSURE_ROW_ALIGN 32
+
+/*
+ * Reachability bitsets for a tile of target vertices, the ids first to
+ * first + n - 1. Row i of desc (and anc) belongs to the vertex with id i,
+ * and bit j of it to the vertex with id first + j.
+ */
+struct DagClosure {
+    struct Dag *d;
+    unsigned long version;
+    int first;
+    int n;
+    int v_count;
+    size_t row_words;
+    uint64_t *desc;
+    uint64_t *anc;
+};
+
+typedef void (*bits_or_func)(uint64_t *dst, const uint64_t *src, size_t n);
+
+static void dag_bits_or_scalar(uint64_t *dst, const uint64_t *src, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        dst[i] |= src[i];
+    }
+}
+
+#ifdef CLOSURE_X86
+#ifdef __SSE2__
+static void dag_bits_or_sse2(uint64_t *dst, const uint64_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i a = _mm_loadu_si128((const __m128i *) &dst[i]);
+        __m128i b = _mm_loadu_si128((const __m128i *) &src[i]);
+        _mm_storeu_si128((__m128i *) &dst[i], _mm_or_si128(a, b));
+    }
+    dag_bits_or_scalar(&dst[i], &src[i], n - i);
+}
+#endif
+
+__attribute__((target("avx2")))
+static void dag_bits_or_avx2(uint64_t *dst, const uint64_t *src, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) &dst[i]);
+        __m256i b = _mm256_loadu_si256((const __m256i *) &src[i]);
+        _mm256_storeu_si256((__m256i *) &dst[i], _mm256_or_si256(a, b));
+    }
+    dag_bits_or_scalar(&dst[i], &src[i], n - i);
+}
+#endif
+
+/**
+ * Picks the widest OR the processor supports: AVX2, SSE2 or plain 64 bit
+ * words.
+ */
+static bits_or_func dag_bits_or_select(void) {
+#ifdef CLOSURE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return dag_bits_or_avx2;
+    }
+#ifdef __SSE2__
+    return dag_bits_or_sse2;
+#endif
+#endif
+    return dag_bits_or_scalar;
+}
+
+/**
+ * ORs n words of src into dst, using vector instructions where available.
+ */
+void dag_bits_or(uint64_t *dst, const uint64_t *src, size_t n) {
+    static bits_or_func bits_or = NULL;
+    // Every thread picks the same function, so a racing store is harmless.
+    bits_or_func f = __atomic_load_n(&bits_or, __ATOMIC_RELAXED);
+    if (f == NULL) {
+        f = dag_bits_or_select();
+        __atomic_store_n(&bits_or, f, __ATOMIC_RELAXED);
+    }
+    f(dst, src, n);
+}
+
+static inline bool closure_bit_test(const uint64_t *bits, int i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+static inline void closure_bit_set(uint64_t *bits, int i) {
+    bits[i / 64] |= (uint64_t) 1 << (i % 64);
+}
+
+/**
+ * Fills in the rows of one direction. Vertices are visited so that the
+ * neighbours in that direction come first, and each row is the union of
+ * the rows and bits of those neighbours. Vertices beyond the last one that
+ * can have a bit in the tile are skipped, leaving their rows zero.
+ * forward - true for descendants, visiting in reverse topological order;
+ *           false for ancestors, visiting in topological order.
+ */
+static void closure_fill(struct DagClosure *c, struct Vertex **order,
+                         int n_order, int lo_rank, int hi_rank, bool forward,
+                         uint64_t *rows) {
+    int start = forward ? hi_rank : lo_rank;
+    int end = forward ? -1 : n_order;
+    int step = forward ? -1 : 1;
+
+    for (int i = start; i != end; i += step) {
+        struct Vertex *u = order[i];
+        uint64_t *row = &rows[(size_t) u->id * c->row_words];
+        int degree = forward ? u->out_size : u->in_size;
+        DAG_STAT_ADD(c->d, vertices_visited, 1);
+        DAG_STAT_ADD(c->d, edges_scanned, degree);
+
+        for (int j = 0; j < degree; j++) {
+            struct Vertex *w = forward ? u->out[j]->to : u->in[j]->from;
+            dag_bits_or(row, &rows[(size_t) w->id * c->row_words],
+                        c->row_words);
+            if (w->id >= c->first && w->id < c->first + c->n) {
+                closure_bit_set(row, w->id - c->first);
+            }
+        }
+    }
+}
+
+/**
+ * Builds the descendant bitsets, and optionally the ancestor bitsets, of
+ * every vertex over a tile of target vertices.
+ * return - the closure; null if an error occurred.
+ */
+struct DagClosure *dag_closure_build(struct Dag *d, int first_id, int n_ids,
+                                     bool ancestors) {
+    DAG_STAT_CALL(d, DAG_API_CLOSURE_BUILD);
+    if (!d || first_id < 0 || n_ids < 0 || n_ids > d->id - first_id) {
+        return NULL;
+    }
+
+    int n_order;
+    struct Vertex **order = dag_topological_order(d, &n_order);
+    if (order == NULL) return NULL;
+
+    struct DagClosure *c = malloc(sizeof(*c));
+    if (c == NULL) return NULL;
+
+    size_t align_words = CLOSURE_ROW_ALIGN / sizeof(uint64_t);
+    c->d = d;
+    c->version = d->version;
+    c->first = first_id;
+    c->n = n_ids;
+    c->v_count = d->id;
+    c->row_words = ((size_t) n_ids + 63) / 64;
+    c->row_words = (c->row_words + align_words - 1) / align_words
+                   * align_words;
+    // aligned_alloc() takes a non-zero multiple of the alignment, which
+    // whole rows are.
+    size_t bytes = (size_t) d->id * c->row_words * sizeof(uint64_t);
+    if (bytes == 0) bytes = CLOSURE_ROW_ALIGN;
+    c->desc = aligned_alloc(CLOSURE_ROW_ALIGN, bytes);
+    c->anc = ancestors ? aligned_alloc(CLOSURE_ROW_ALIGN, bytes) : NULL;
+    if (!c->desc || (ancestors && !c->anc)) {
+        dag_closure_destroy(c);
+        return NULL;
+    }
+    memset(c->desc, 0, bytes);
+    if (c->anc) {
+        memset(c->anc, 0, bytes);
+    }
+
+    // Only vertices ranked up to the last tile vertex can have descendants
+    // in the tile, and only those ranked from the first one ancestors.
+    // Removed vertices are not ordered, but have no edges either.
+    int lo_rank = n_order;
+    int hi_rank = -1;
+    for (int i = 0; i < n_order; i++) {
+        int id = order[i]->id;
+        if (id >= first_id && id < first_id + n_ids) {
+            if (i < lo_rank) lo_rank = i;
+            hi_rank = i;
+        }
+    }
+
+    if (hi_rank >= 0) {
+        closure_fill(c, order, n_order, lo_rank, hi_rank, true, c->desc);
+        if (c->anc) {
+            closure_fill(c, order, n_order, lo_rank, hi_rank, false, c->anc);
+        }
+    }
+
+    return c;
+}
+
+/**
+ * Gets the descendant bitset of a vertex.
+ */
+const uint64_t *dag_descendants(struct DagClosure *c, struct Vertex *v) {
+    if (!c || !v || c->version != c->d->version || v->id >= c->v_count) {
+        return NULL;
+    }
+
+    return &c->desc[(size_t) v->id * c->row_words];
+}
+
+/**
+ * Gets the ancestor bitset of a vertex.
+ */
+const uint64_t *dag_ancestors(struct DagClosure *c, struct Vertex *v) {
+    if (!c || !c->anc || !v || c->version != c->d->version 
+            || v->id >= c->v_count) {
+        return NULL;
+    }
+
+    return &c->anc[(size_t) v->id * c->row_words];
+}
+
+/**
+ * Gets the ids of the target vertices of a closure.
+ */
+void dag_closure_range(struct DagClosure *c, int *first_id, int *n_ids) {
+    if (first_id) *first_id = c->first;
+    if (n_ids) *n_ids = c->n;
+}
+
+/**
+ * Checks if there is a path from a to b by testing one bit.
+ * return - 1 if connected; 0 if not connected; -1 if b is not in the tile,
+ *          or the graph has been modified.
+ */
+int dag_closure_reaches(struct DagClosure *c, struct Vertex *a,
+                        struct Vertex *b) {
+    if (!c || !a || !b || c->version != c->d->version) return -1;
+    if (a->id >= c->v_count || b->id < c->first || b->id >= c->first + c->n) {
+        return -1;
+    }
+
+    return closure_bit_test(dag_descendants(c, a), b->id - c->first);
+}
+
+/**
+ * Gets the number of bytes used by a closure.
+ */
+size_t dag_closure_memory(struct DagClosure *c) {
+    size_t rows = (size_t) c->v_count * c->row_words * sizeof(uint64_t);
+    return sizeof(*c) + (c->anc ? 2 * rows : rows);
+}
+
+/**
+ * Frees a closure.
+ */
+void dag_closure_destroy(struct DagClosure *c) {
+    if (c == NULL) return;
+
+    free(c->desc);
+    free(c->anc);
+    free(c);
+}
@@ -0,0 +1,385 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+// Readers are kept on separate cache lines, so that announcing an epoch does
+// not contend with other readers.
+#define SHARED_CACHE_LINE 64
+
+/*
+ * An immutable copy of the graph, published to readers. The outgoing edges
+ * of vertex v are out_targets[out_offsets[v]] to
+ * out_targets[out_offsets[v + 1] - 1]. Every array is part of the same
+ * allocation as the view.
+ */
+struct DagView {
+    uint64_t version;
+    // Vertex ids are less than n, and n_live of them are not removed.
+    int n;
+    int n_live;
+    int m;
+    int32_t *out_offsets;
+    int32_t *out_targets;
+    int32_t *topo_order;
+    int32_t *rank;
+    // Set when the view is replaced: the epoch it was retired in, and the
+    // next view waiting to be freed.
+    uint64_t retire_epoch;
+    struct DagView *next;
+};
+
+/*
+ * A reader slot. epoch is 0 while the reader is outside a read section, and
+ * otherwise at most the global epoch at which the section started. The
+ * search scratch space is private to the thread owning the slot.
+ */
+struct DagReader {
+    _Alignas(SHARED_CACHE_LINE) atomic_uint_fast64_t epoch;
+    atomic_bool in_use;
+    struct DagShared *shared;
+    const struct DagView *view;
+    uint32_t *stamps;
+    int32_t *queue;
+    int cap;
+    uint32_t stamp;
+};
+
+struct DagShared {
+    struct Dag *d;
+    pthread_mutex_t write_lock;
+    _Atomic(struct DagView *) current;
+    atomic_uint_fast64_t epoch;
+    // Views replaced but possibly still read, newest first.
+    struct DagView *retired;
+    int n_readers;
+    struct DagReader *readers;
+};
+
+/**
+ * Copies the graph into a new view, in O(V + E) time.
+ * return - the view; null if memory could not be allocated.
+ */
+static struct DagView *shared_view_build(struct Dag *d) {
+    struct Vertex **order = dag_topological_order(d, NULL);
+    if (order == NULL) return NULL;
+
+    int n = d->id;
+    int m = d->e_size;
+    size_t size = sizeof(struct DagView)
+                  + ((size_t) 3 * n + 1 + m) * sizeof(int32_t);
+    struct DagView *view = malloc(size);
+    if (view == NULL) return NULL;
+
+    view->version = d->version;
+    view->n = n;
+    view->n_live = n - d->n_removed;
+    view->m = m;
+    view->out_offsets = (int32_t *) (view + 1);
+    view->out_targets = view->out_offsets + n + 1;
+    view->topo_order = view->out_targets + m;
+    view->rank = view->topo_order + n;
+    view->retire_epoch = 0;
+    view->next = NULL;
+
+    view->out_offsets[0] = 0;
+    for (int v = 0; v < n; v++) {
+        struct Vertex *vx = d->vertices[v];
+        int32_t *targets = &view->out_targets[view->out_offsets[v]];
+        for (int j = 0; j < vx->out_size; j++) {
+            targets[j] = vx->out[j]->to->id;
+        }
+        view->out_offsets[v + 1] = view->out_offsets[v] + vx->out_size;
+        view->topo_order[v] = order[v]->id;
+        view->rank[order[v]->id] = v;
+    }
+
+    return view;
+}
+
+/**
+ * Frees the retired views that no reader can still hold: those retired
+ * before the epoch of every reader inside a read section.
+ */
+static void shared_reclaim(struct DagShared *s) {
+    uint64_t oldest = UINT64_MAX;
+    for (int i = 0; i < s->n_readers; i++) {
+        uint64_t e = atomic_load(&s->readers[i].epoch);
+        if (e != 0 && e < oldest) {
+            oldest = e;
+        }
+    }
+
+    struct DagView **link = &s->retired;
+    while (*link != NULL) {
+        struct DagView *view = *link;
+        if (view->retire_epoch < oldest) {
+            *link = view->next;
+            free(view);
+        } else {
+            link = &view->next;
+        }
+    }
+}
+
+/**
+ * Publishes a view of the graph in its current state, and retires the
+ * previous one. Must be called with the write lock held.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int shared_publish(struct DagShared *s) {
+    struct DagView *view = shared_view_build(s->d);
+    if (view == NULL) return -1;
+
+    struct DagView *old = atomic_exchange(&s->current, view);
+    // A reader that announces a later epoch loads the pointer after the
+    // exchange, so it can only get the new view.
+    old->retire_epoch = atomic_fetch_add(&s->epoch, 1);
+    old->next = s->retired;
+    s->retired = old;
+    shared_reclaim(s);
+
+    return 0;
+}
+
+/**
+ * Shares a graph between one writer at a time and up to max_readers reader
+ * threads.
+ * return - the shared graph; null if an error occurred.
+ */
+struct DagShared *dag_shared_create(struct Dag *d, int max_readers) {
+    if (!d || max_readers < 1) return NULL;
+
+    struct DagShared *s = malloc(sizeof(*s));
+    struct DagReader *readers = aligned_alloc(SHARED_CACHE_LINE,
+                                              max_readers * sizeof(*readers));
+    struct DagView *view = shared_view_build(d);
+    if (!s || !readers || !view || pthread_mutex_init(&s->write_lock, NULL)) {
+        free(s);
+        free(readers);
+        free(view);
+        return NULL;
+    }
+
+    s->d = d;
+    atomic_init(&s->current, view);
+    atomic_init(&s->epoch, 1);
+    s->retired = NULL;
+    s->n_readers = max_readers;
+    s->readers = readers;
+    for (int i = 0; i < max_readers; i++) {
+        struct DagReader *r = &readers[i];
+        atomic_init(&r->epoch, 0);
+        atomic_init(&r->in_use, false);
+        r->shared = s;
+        r->view = NULL;
+        r->stamps = NULL;
+        r->queue = NULL;
+        r->cap = 0;
+        r->stamp = 0;
+    }
+
+    return s;
+}
+
+/**
+ * Frees a shared graph and all of its views. The graph itself is not freed.
+ */
+void dag_shared_destroy(struct DagShared *s) {
+    if (s == NULL) return;
+
+    for (int i = 0; i < s->n_readers; i++) {
+        free(s->readers[i].stamps);
+        free(s->readers[i].queue);
+    }
+    while (s->retired != NULL) {
+        struct DagView *view = s->retired;
+        s->retired = view->next;
+        free(view);
+    }
+    free(atomic_load(&s->current));
+    pthread_mutex_destroy(&s->write_lock);
+    free(s->readers);
+    free(s);
+}
+
+/**
+ * Starts a batch of changes to a shared graph.
+ * return - the graph to change.
+ */
+struct Dag *dag_shared_write_begin(struct DagShared *s) {
+    pthread_mutex_lock(&s->write_lock);
+    return s->d;
+}
+
+/**
+ * Ends a batch of changes, publishing them if the graph was modified.
+ * return - 0 on success; -1 if the changes could not be published.
+ */
+int dag_shared_write_end(struct DagShared *s) {
+    int res = 0;
+    if (atomic_load(&s->current)->version != s->d->version) {
+        res = shared_publish(s);
+    }
+    pthread_mutex_unlock(&s->write_lock);
+
+    return res;
+}
+
+/**
+ * Claims a free reader slot.
+ * return - the reader; null if all slots are taken.
+ */
+struct DagReader *dag_reader_register(struct DagShared *s) {
+    for (int i = 0; i < s->n_readers; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&s->readers[i].in_use, &expected,
+                                           true)) {
+            return &s->readers[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Releases a reader slot. The reader must not be inside a read section.
+ */
+void dag_reader_unregister(struct DagReader *r) {
+    if (r == NULL) return;
+
+    atomic_store(&r->in_use, false);
+}
+
+/**
+ * Starts a read section, by announcing the current epoch and then loading
+ * the current view.
+ */
+const struct DagView *dag_read_begin(struct DagReader *r) {
+    struct DagShared *s = r->shared;
+    atomic_store(&r->epoch, atomic_load(&s->epoch));
+    r->view = atomic_load(&s->current);
+
+    return r->view;
+}
+
+/**
+ * Ends a read section.
+ */
+void dag_read_end(struct DagReader *r) {
+    r->view = NULL;
+    atomic_store_explicit(&r->epoch, 0, memory_order_release);
+}
+
+/**
+ * Gets the version of the graph that a view copies.
+ */
+uint64_t dag_view_version(const struct DagView *view) {
+    return view->version;
+}
+
+/**
+ * Gets the number of vertices in a view.
+ */
+int dag_view_vertex_count(const struct DagView *view) {
+    return view->n;
+}
+
+/**
+ * Gets the number of edges in a view.
+ */
+int dag_view_edge_count(const struct DagView *view) {
+    return view->m;
+}
+
+/**
+ * Returns the ids of the successors of vertex id in a view.
+ */
+const int32_t *dag_view_successors(const struct DagView *view, int id,
+                                   int *n) {
+    *n = view->out_offsets[id + 1] - view->out_offsets[id];
+    return &view->out_targets[view->out_offsets[id]];
+}
+
+/**
+ * Gets the topological order of a view, as vertex ids.
+ */
+const int32_t *dag_view_topological_order(const struct DagView *view, int *n) {
+    // Removed vertices are ordered last, and left out.
+    if (n) *n = view->n_live;
+    return view->topo_order;
+}
+
+/**
+ * Makes sure the scratch space of a reader can hold n vertices.
+ * return - 0 on success; -1 if memory could not be allocated.
+ */
+static int reader_reserve(struct DagReader *r, int n) {
+    if (r->cap >= n) return 0;
+
+    int new_cap = r->cap * 2 > n ? r->cap * 2 : n;
+    uint32_t *stamps = calloc(new_cap, sizeof(*stamps));
+    int32_t *queue = malloc(new_cap * sizeof(*queue));
+    if (!stamps || !queue) {
+        free(stamps);
+        free(queue);
+        return -1;
+    }
+
+    free(r->stamps);
+    free(r->queue);
+    r->stamps = stamps;
+    r->queue = queue;
+    r->cap = new_cap;
+    r->stamp = 0;
+
+    return 0;
+}
+
+/**
+ * Checks if there is a path from vertex a to vertex b in the view of the
+ * current read section, with a breadth first search pruned by the ranks of
+ * the topological order. Vertices are marked visited with a stamp that
+ * changes every search, so the scratch space is never cleared.
+ * return - 1 if connected; 0 if not connected; -1 if an error occurred.
+ */
+int dag_view_is_connected(struct DagReader *r, int a, int b) {
+    const struct DagView *view = r->view;
+    if (!view || a < 0 || b < 0 || a >= view->n || b >= view->n) return -1;
+    if (a == b) return 1;
+    if (view->rank[a] > view->rank[b]) return 0;
+    if (reader_reserve(r, view->n) < 0) return -1;
+
+    if (++r->stamp == 0) {
+        memset(r->stamps, 0, r->cap * sizeof(*r->stamps));
+        r->stamp = 1;
+    }
+
+    int head = 0;
+    int tail = 0;
+    int32_t b_rank = view->rank[b];
+    r->stamps[a] = r->stamp;
+    r->queue[tail++] = a;
+
+    while (head < tail) {
+        int v = r->queue[head++];
+        for (int32_t i = view->out_offsets[v]; i < view->out_offsets[v + 1];
+                i++) {
+            int w = view->out_targets[i];
+            if (w == b) return 1;
+            if (r->stamps[w] == r->stamp || view->rank[w] > b_rank) {
+                continue;
+            }
+            r->stamps[w] = r->stamp;
+            r->queue[tail++] = w;
+        }
+    }
+
+    return 0;
+}
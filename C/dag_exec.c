@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+#define DEQUE_EMPTY -1
+#define DEQUE_ABORT -2
+
+/**
+ * Chase-Lev work-stealing deque of vertex ids. The owner pushes and takes at
+ * the bottom, thieves steal from the top. Every vertex is pushed exactly
+ * once during an execution, so the buffer holds one slot per vertex and the
+ * indices never wrap around.
+ */
+struct Deque {
+    atomic_int top;
+    atomic_int bottom;
+    atomic_int *items;
+};
+
+// State shared by the executing threads.
+struct ExecWork {
+    struct Dag *d;
+    task_func task;
+    void *ctx;
+    double *task_seconds;
+    atomic_int *pending;
+    struct Deque *deques;
+    int n_workers;
+    atomic_int remaining;
+    atomic_bool failed;
+};
+
+struct ExecWorker {
+    struct ExecWork *work;
+    int tid;
+    unsigned rand;
+};
+
+static double dag_exec_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Pushes a vertex id to the bottom of the deque. Only called by the owner.
+ */
+static void deque_push(struct Deque *q, int id) {
+    int b = atomic_load_explicit(&q->bottom, memory_order_relaxed);
+    atomic_store_explicit(&q->items[b], id, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+}
+
+/**
+ * Takes a vertex id from the bottom of the deque. Only called by the owner.
+ * return - the id; DEQUE_EMPTY if the deque is empty.
+ */
+static int deque_take(struct Deque *q) {
+    int b = atomic_load_explicit(&q->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&q->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int t = atomic_load_explicit(&q->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+
+    int id = atomic_load_explicit(&q->items[b], memory_order_relaxed);
+    if (t == b) {
+        // Last item, race the thieves for it.
+        if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+                memory_order_seq_cst, memory_order_relaxed)) {
+            id = DEQUE_EMPTY;
+        }
+        atomic_store_explicit(&q->bottom, b + 1, memory_order_relaxed);
+    }
+    return id;
+}
+
+/**
+ * Steals a vertex id from the top of the deque of another worker.
+ * return - the id; DEQUE_EMPTY if the deque is empty; DEQUE_ABORT if 
+ *          another thread got the item first.
+ */
+static int deque_steal(struct Deque *q) {
+    int t = atomic_load_explicit(&q->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int b = atomic_load_explicit(&q->bottom, memory_order_acquire);
+
+    if (t >= b) {
+        return DEQUE_EMPTY;
+    }
+
+    int id = atomic_load_explicit(&q->items[t], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&q->top, &t, t + 1,
+            memory_order_seq_cst, memory_order_relaxed)) {
+        return DEQUE_ABORT;
+    }
+    return id;
+}
+
+/**
+ * Tries to steal a task from the other workers, starting at a random victim.
+ * return - the stolen vertex id; DEQUE_EMPTY if no work was found.
+ */
+static int dag_exec_steal(struct ExecWorker *w) {
+    struct ExecWork *work = w->work;
+
+    // xorshift32
+    w->rand ^= w->rand << 13;
+    w->rand ^= w->rand >> 17;
+    w->rand ^= w->rand << 5;
+
+    int start = w->rand % work->n_workers;
+    for (int i = 0; i < work->n_workers; i++) {
+        int victim = (start + i) % work->n_workers;
+        if (victim == w->tid) {
+            continue;
+        }
+
+        int id;
+        while ((id = deque_steal(&work->deques[victim])) == DEQUE_ABORT) {
+        }
+        if (id != DEQUE_EMPTY) {
+            return id;
+        }
+    }
+    return DEQUE_EMPTY;
+}
+
+/**
+ * Runs one task and releases the successors it was the last predecessor of
+ * onto the deque of the worker.
+ */
+static void dag_exec_run(struct ExecWorker *w, int id) {
+    struct ExecWork *work = w->work;
+    struct Vertex *v = work->d->vertices[id];
+
+    double start = work->task_seconds ? dag_exec_now() : 0;
+    int res = work->task(v, work->ctx);
+    if (work->task_seconds) {
+        work->task_seconds[id] = dag_exec_now() - start;
+    }
+
+    if (res != 0) {
+        atomic_store(&work->failed, true);
+        return;
+    }
+
+    for (int i = 0; i < v->out_size; i++) {
+        int to = v->out[i]->to->id;
+        if (atomic_fetch_sub_explicit(&work->pending[to], 1, 
+                                      memory_order_acq_rel) == 1) {
+            deque_push(&work->deques[w->tid], to);
+        }
+    }
+    atomic_fetch_sub_explicit(&work->remaining, 1, memory_order_release);
+}
+
+static void *dag_exec_worker(void *arg) {
+    struct ExecWorker *w = arg;
+    struct ExecWork *work = w->work;
+
+    while (atomic_load_explicit(&work->remaining, memory_order_acquire) > 0 
+            && !atomic_load_explicit(&work->failed, memory_order_relaxed)) {
+        int id = deque_take(&work->deques[w->tid]);
+        if (id == DEQUE_EMPTY) {
+            id = dag_exec_steal(w);
+        }
+
+        if (id == DEQUE_EMPTY) {
+            sched_yield();
+        } else {
+            dag_exec_run(w, id);
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Runs a task for every vertex of the graph. A task is started once the tasks
+ * of all predecessors of its vertex have finished. Ready tasks are kept in
+ * one work-stealing deque per thread: a thread runs the tasks it released
+ * itself first and steals from the others when it runs out.
+ * d - graph whose vertices to run. It must not be modified meanwhile.
+ * task - called once for each vertex with ctx. Returning non-zero stops the 
+ *        execution once the running tasks have finished.
+ * ctx - passed on to task.
+ * n_threads - number of threads to use, including the calling thread. If
+ *             fewer threads can be started, the ones that were are used.
+ * task_seconds - if not null, receives the wall time of the task of each
+ *                vertex, indexed by vertex id.
+ * total_seconds - if not null, receives the wall time of the execution.
+ * return - 0 if every task has run; 1 if a task stopped the execution; 
+ *          -1 if an error occurred.
+ */
+int dag_execute(struct Dag *d, task_func task, void *ctx, int n_threads,
+                double *task_seconds, double *total_seconds) {
+    DAG_STAT_CALL(d, DAG_API_EXECUTE);
+    if (!d || !task) return -1;
+    if (n_threads < 1) n_threads = 1;
+
+    double start = dag_exec_now();
+    int v_count = d->id;
+    struct ExecWork work;
+    struct ExecWorker *workers = calloc(n_threads, sizeof(*workers));
+    pthread_t *threads = malloc(n_threads * sizeof(*threads));
+    work.deques = calloc(n_threads, sizeof(*work.deques));
+    work.pending = malloc((v_count + 1) * sizeof(*work.pending));
+
+    bool ok = workers && threads && work.deques && work.pending;
+    for (int t = 0; ok && t < n_threads; t++) {
+        work.deques[t].items = malloc((v_count + 1) * sizeof(atomic_int));
+        ok = work.deques[t].items != NULL;
+    }
+    if (!ok) {
+        for (int t = 0; work.deques && t < n_threads; t++) {
+            free(work.deques[t].items);
+        }
+        free(work.deques);
+        free(work.pending);
+        free(workers);
+        free(threads);
+        return -1;
+    }
+
+    work.d = d;
+    work.task = task;
+    work.ctx = ctx;
+    work.task_seconds = task_seconds;
+    work.n_workers = n_threads;
+    atomic_init(&work.remaining, v_count - d->n_removed);
+    atomic_init(&work.failed, false);
+
+    // Deal the sources out to the workers.
+    int dealt = 0;
+    for (int t = 0; t < n_threads; t++) {
+        atomic_init(&work.deques[t].top, 0);
+        atomic_init(&work.deques[t].bottom, 0);
+    }
+    for (int v = 0; v < v_count; v++) {
+        atomic_init(&work.pending[v], d->vertices[v]->in_size);
+        if (d->vertices[v]->in_size == 0 && !d->vertices[v]->removed) {
+            deque_push(&work.deques[dealt++ % n_threads], v);
+        }
+    }
+
+    // Deques of workers that cannot be started are emptied by stealing.
+    int n_started = 1;
+    for (int t = 0; t < n_threads; t++) {
+        workers[t].work = &work;
+        workers[t].tid = t;
+        workers[t].rand = 2654435761u * (t + 1);
+    }
+    for (int t = 1; t < n_threads; t++) {
+        if (pthread_create(&threads[t], NULL, dag_exec_worker, 
+                           &workers[t]) != 0) {
+            break;
+        }
+        n_started++;
+    }
+
+    dag_exec_worker(&workers[0]);
+
+    for (int t = 1; t < n_started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    int res = atomic_load(&work.failed) ? 1 : 0;
+
+    for (int t = 0; t < n_threads; t++) {
+        free(work.deques[t].items);
+    }
+    free(work.deques);
+    free(work.pending);
+    free(workers);
+    free(threads);
+
+    if (total_seconds) {
+        *total_seconds = dag_exec_now() - start;
+    }
+    return res;
+}
@@ -0,0 +1,135 @@
+#ifndef DAG_INTERNAL_H
+#define DAG_INTERNAL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "dag.h"
+
+#ifdef DAG_STATS
+// Adds n to one of the counters of struct DagStats.
+#define DAG_STAT_ADD(d, field, n) ((d)->stats.field += (n))
+// Counts a call of an API function, and times it until the enclosing scope
+// is left.
+#define DAG_STAT_CALL(d, api) \
+    struct DagStatCall dag_stat_call_ \
+        __attribute__((cleanup(dag_stat_call_end))) = \
+        dag_stat_call_begin(d, api)
+#else
+// The arguments stay referenced but are not evaluated.
+#define DAG_STAT_ADD(d, field, n) ((void) sizeof(n))
+#define DAG_STAT_CALL(d, api) ((void) 0)
+#endif
+
+/*
+ * Internal representation of the dag, shared by the files implementing
+ * dag.h. Users of the dag should only include dag.h.
+ */
+
+struct Vertex {
+    int id;
+    void *weight;
+    // Outgoing and incoming edges, kept up to date by dag_add_edge().
+    struct Edge **out;
+    int out_size;
+    int out_cap;
+    struct Edge **in;
+    int in_size;
+    int in_cap;
+    // Position in a topological order of the graph, maintained online.
+    int topo_rank;
+    // Equal to the dags mark_epoch when visited by the current search.
+    unsigned int mark;
+    // Set when the vertex is a tombstone left by dag_remove_vertex(), 
+    // without edges, until dag_compact() frees it.
+    bool removed;
+};
+
+struct Edge {
+    struct Vertex *from;
+    struct Vertex *to;
+    void *weight;
+    // Positions in the dags edge array, from->out and to->in, so that the
+    // edge can be removed from each in O(1).
+    int index;
+    int out_pos;
+    int in_pos;
+};
+
+struct Dag {
+    add_weight_func add;
+    weight_comp_func comp;
+    // All vertices indexed by id, and all edges. Removed edges are replaced
+    // by the last one.
+    struct Vertex **vertices;
+    int v_cap;
+    struct Edge **edges;
+    int e_size;
+    int e_cap;
+    // Storage for vertices, edges and adjacency arrays in ALLOC_ARENA mode;
+    // NULL if they are allocated one by one.
+    struct Arena *arena;
+    int id;
+    // Number of vertices removed since the last dag_compact().
+    int n_removed;
+    unsigned int mark_epoch;
+    // Scratch space reused by dag_reachable(), indexed by vertex id. The
+    // bitsets are all zero between searches.
+    uint64_t *seen[2];
+    struct Vertex **frontier[2];
+    int search_cap;
+    // Bumped by every change to the graph.
+    unsigned long version;
+    struct ReachIndex *reach;
+    // Cached result of dag_topological_order(), valid while
+    // topo_order_version equals version.
+    struct Vertex **topo_order;
+    int topo_order_cap;
+    unsigned long topo_order_version;
+    // Open addressing hash table of edges, keyed on (from id, to id).
+    struct Edge **edge_table;
+    size_t edge_table_cap;
+    size_t edge_table_size;
+    enum DuplicateEdges duplicates;
+#ifdef DAG_STATS
+    // Counters, with bytes_live only covering the elements from dag_alloc().
+    struct DagStats stats;
+#endif
+};
+
+/*
+ * Interval labels from a depth first search of the whole graph, indexed by
+ * vertex id. [pre, post] identifies the subtree of a vertex in the search
+ * forest, and [low, post] covers the post numbers of every vertex it can
+ * reach.
+ */
+struct ReachIndex {
+    unsigned long version;
+    int size;
+    int *pre;
+    int *post;
+    int *low;
+};
+
+#ifdef DAG_STATS
+struct DagStatCall {
+    struct Dag *d;
+    enum DagApi api;
+    uint64_t start;
+};
+
+struct DagStatCall dag_stat_call_begin(struct Dag *d, enum DagApi api);
+void dag_stat_call_end(struct DagStatCall *call);
+#endif
+
+// ORs n words of src into dst, with the widest vector instructions the
+// processor supports.
+void dag_bits_or(uint64_t *dst, const uint64_t *src, size_t n);
+
+// Removes an edge from the graph and frees it, as dag_remove_edge() does.
+// If replace is set, a parallel edge takes over its slot in the edge table.
+void dag_unlink_edge(struct Dag *d, struct Edge *e, bool replace,
+                     bool free_weight);
+
+#endif
@@ -0,0 +1,496 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "arena.h"
+#include "dag.h"
+#include "dag_internal.h"
+
+// Size of the chunks the input is read in.
+#define LOAD_CHUNK ((size_t) 1 << 20)
+// Size of the blocks keys and weights are carved from.
+#define LOAD_BLOCK ((size_t) 1 << 16)
+
+// An entry of the key table, empty while vertex is null. The key is kept
+// next to the hash so that probing does not have to go through the vertex.
+struct LoadKey {
+    uint64_t hash;
+    const void *key;
+    struct Vertex *vertex;
+};
+
+struct EdgeList {
+    struct Dag *d;
+    enum LoadKeys keys;
+    // Open addressing hash table mapping keys to vertices, whose weights
+    // point to the interned keys.
+    struct LoadKey *table;
+    size_t table_cap;
+    size_t table_size;
+    // Keys and edge weights are stored in blocks from the arena.
+    struct Arena *arena;
+    char *block;
+    size_t block_left;
+    // The parsed edges, added to the graph at once.
+    struct Vertex **from;
+    struct Vertex **to;
+    void **weights;
+    int64_t *lines;
+    int n_edges;
+    int edges_cap;
+};
+
+static double load_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Hashes a key with FNV-1a, finished with a mixing step so that the low bits
+ * used to index the table depend on every byte.
+ */
+static uint64_t load_hash(const char *key, size_t len) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (unsigned char) key[i];
+        h *= 1099511628211ull;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * Parses a decimal integer with an optional sign.
+ * return - 0 on success; -1 if the text is not a number or overflows.
+ */
+static int load_parse_int(const char *s, size_t len, int64_t *res) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < len && (s[i] == '-' || s[i] == '+')) {
+        negative = s[i] == '-';
+        i++;
+    }
+    if (i == len) return -1;
+
+    uint64_t value = 0;
+    uint64_t limit = negative ? (uint64_t) INT64_MAX + 1 : INT64_MAX;
+    for (; i < len; i++) {
+        unsigned digit = (unsigned char) s[i] - '0';
+        if (digit > 9 || value > (limit - digit) / 10) return -1;
+        value = value * 10 + digit;
+    }
+
+    *res = negative ? (int64_t) (0 - value) : (int64_t) value;
+    return 0;
+}
+
+/**
+ * Carves size bytes, aligned for an int64_t, from the current block.
+ * return - the memory; null if it could not be allocated.
+ */
+static void *load_alloc(struct EdgeList *l, size_t size) {
+    size = (size + 7) & ~(size_t) 7;
+    if (size > l->block_left) {
+        size_t block = size > LOAD_BLOCK ? size : LOAD_BLOCK;
+        l->block = arena_alloc(l->arena, block);
+        if (l->block == NULL) return NULL;
+        l->block_left = block;
+    }
+
+    void *p = l->block;
+    l->block += size;
+    l->block_left -= size;
+    return p;
+}
+
+/**
+ * Doubles the key table when it is half full.
+ * return - 0 on success; -1 on allocation failure.
+ */
+static int load_table_reserve(struct EdgeList *l) {
+    if (2 * (l->table_size + 1) <= l->table_cap) return 0;
+
+    size_t cap = l->table_cap ? 2 * l->table_cap : 1024;
+    struct LoadKey *table = calloc(cap, sizeof(*table));
+    if (!table) return -1;
+
+    for (size_t i = 0; i < l->table_cap; i++) {
+        if (l->table[i].vertex == NULL) continue;
+        size_t j = l->table[i].hash & (cap - 1);
+        while (table[j].vertex != NULL) {
+            j = (j + 1) & (cap - 1);
+        }
+        table[j] = l->table[i];
+    }
+
+    free(l->table);
+    l->table = table;
+    l->table_cap = cap;
+    return 0;
+}
+
+/**
+ * Checks whether an interned key equals the given key.
+ */
+static bool load_key_equals(struct EdgeList *l, const void *interned,
+                            const char *key, size_t len, int64_t num) {
+    if (l->keys == KEYS_INTEGER) {
+        return *(const int64_t *) interned == num;
+    }
+    const char *s = interned;
+    return strncmp(s, key, len) == 0 && s[len] == '\0';
+}
+
+/**
+ * Finds the vertex of a key in the table.
+ * return - the vertex; null if the key is unknown.
+ */
+static struct Vertex *load_find(struct EdgeList *l, const char *key,
+                                size_t len, int64_t num, uint64_t hash) {
+    if (l->table_cap == 0) return NULL;
+
+    size_t i = hash & (l->table_cap - 1);
+    while (l->table[i].vertex != NULL) {
+        if (l->table[i].hash == hash
+                && load_key_equals(l, l->table[i].key, key, len, num)) {
+            return l->table[i].vertex;
+        }
+        i = (i + 1) & (l->table_cap - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Maps a key to its vertex, adding a vertex for keys not seen before.
+ * return - the vertex; null if the key is not an integer in integer mode,
+ *          or memory could not be allocated.
+ */
+static struct Vertex *load_vertex(struct EdgeList *l, const char *key,
+                                  size_t len) {
+    int64_t num = 0;
+    uint64_t hash;
+    if (l->keys == KEYS_INTEGER) {
+        if (load_parse_int(key, len, &num) != 0) return NULL;
+        hash = load_hash((const char *) &num, sizeof(num));
+    } else {
+        hash = load_hash(key, len);
+    }
+
+    struct Vertex *v = load_find(l, key, len, num, hash);
+    if (v != NULL) return v;
+
+    if (load_table_reserve(l) != 0) return NULL;
+
+    void *w;
+    if (l->keys == KEYS_INTEGER) {
+        w = load_alloc(l, sizeof(num));
+        if (w) *(int64_t *) w = num;
+    } else {
+        w = load_alloc(l, len + 1);
+        if (w) {
+            memcpy(w, key, len);
+            ((char *) w)[len] = '\0';
+        }
+    }
+    if (!w || !(v = dag_add_vertex(l->d, w))) return NULL;
+
+    size_t i = hash & (l->table_cap - 1);
+    while (l->table[i].vertex != NULL) {
+        i = (i + 1) & (l->table_cap - 1);
+    }
+    l->table[i].hash = hash;
+    l->table[i].key = w;
+    l->table[i].vertex = v;
+    l->table_size++;
+
+    return v;
+}
+
+/**
+ * Parses one line of the edge list into a pending edge. Empty lines and
+ * lines starting with '#' are skipped.
+ * return - 0 on success; -1 if the line is malformed or memory ran out.
+ */
+static int load_line(struct EdgeList *l, const char *line, size_t len,
+                     char delim, int64_t line_no) {
+    if (len > 0 && line[len - 1] == '\r') len--;
+    if (len == 0 || line[0] == '#') return 0;
+
+    const char *field[3];
+    size_t field_len[3];
+    int n_fields = 0;
+    const char *start = line;
+    const char *end = line + len;
+    while (n_fields < 3) {
+        const char *sep = memchr(start, delim, end - start);
+        const char *stop = sep ? sep : end;
+        field[n_fields] = start;
+        field_len[n_fields++] = stop - start;
+        if (!sep) break;
+        start = sep + 1;
+    }
+    if (n_fields < 2 || field_len[0] == 0 || field_len[1] == 0) return -1;
+
+    if (l->n_edges == l->edges_cap) {
+        int cap = l->edges_cap ? 2 * l->edges_cap : 1024;
+        struct Vertex **from = realloc(l->from, cap * sizeof(*from));
+        if (from) l->from = from;
+        struct Vertex **to = realloc(l->to, cap * sizeof(*to));
+        if (to) l->to = to;
+        void **weights = realloc(l->weights, cap * sizeof(*weights));
+        if (weights) l->weights = weights;
+        int64_t *lines = realloc(l->lines, cap * sizeof(*lines));
+        if (lines) l->lines = lines;
+        if (!from || !to || !weights || !lines) return -1;
+        l->edges_cap = cap;
+    }
+
+    void *w = NULL;
+    if (n_fields == 3 && field_len[2] > 0) {
+        int64_t num;
+        if (load_parse_int(field[2], field_len[2], &num) != 0) return -1;
+        if (!(w = load_alloc(l, sizeof(num)))) return -1;
+        *(int64_t *) w = num;
+    }
+
+    struct Vertex *a = load_vertex(l, field[0], field_len[0]);
+    struct Vertex *b = a ? load_vertex(l, field[1], field_len[1]) : NULL;
+    if (!a || !b) return -1;
+
+    l->from[l->n_edges] = a;
+    l->to[l->n_edges] = b;
+    l->weights[l->n_edges] = w;
+    l->lines[l->n_edges] = line_no;
+    l->n_edges++;
+    return 0;
+}
+
+/**
+ * Checks whether the graph with the first k pending edges added is acyclic,
+ * by Kahn's algorithm over a copy of the in-degrees.
+ * return - 1 if it is acyclic; 0 if not; -1 on allocation failure.
+ */
+static int load_prefix_acyclic(struct EdgeList *l, int k) {
+    struct Dag *d = l->d;
+    int n = d->id;
+    int *in_degree = malloc((n + 1) * sizeof(*in_degree));
+    int *extra_start = calloc(n + 2, sizeof(*extra_start));
+    int *extra = malloc((k + 1) * sizeof(*extra));
+    int *queue = malloc((n + 1) * sizeof(*queue));
+    int res = -1;
+
+    if (!in_degree || !extra_start || !extra || !queue) goto out;
+
+    // Adjacency of the pending edges, grouped by source.
+    for (int i = 0; i < k; i++) {
+        extra_start[l->from[i]->id + 2]++;
+    }
+    for (int v = 0; v < n; v++) {
+        extra_start[v + 2] += extra_start[v + 1];
+    }
+    for (int i = 0; i < k; i++) {
+        extra[extra_start[l->from[i]->id + 1]++] = l->to[i]->id;
+    }
+
+    int tail = 0;
+    for (int v = 0; v < n; v++) {
+        in_degree[v] = d->vertices[v]->in_size;
+    }
+    for (int i = 0; i < k; i++) {
+        in_degree[l->to[i]->id]++;
+    }
+    for (int v = 0; v < n; v++) {
+        if (in_degree[v] == 0) queue[tail++] = v;
+    }
+
+    for (int head = 0; head < tail; head++) {
+        struct Vertex *v = d->vertices[queue[head]];
+        for (int j = 0; j < v->out_size; j++) {
+            if (--in_degree[v->out[j]->to->id] == 0) {
+                queue[tail++] = v->out[j]->to->id;
+            }
+        }
+        for (int j = extra_start[v->id]; j < extra_start[v->id + 1]; j++) {
+            if (--in_degree[extra[j]] == 0) {
+                queue[tail++] = extra[j];
+            }
+        }
+    }
+    res = tail == n;
+
+out:
+    free(in_degree);
+    free(extra_start);
+    free(extra);
+    free(queue);
+    return res;
+}
+
+/**
+ * Finds the first pending edge, in input order, that closes a cycle, by
+ * binary search over the prefixes of the edges.
+ * return - the index of the edge; -1 on allocation failure.
+ */
+static int load_first_cyclic(struct EdgeList *l) {
+    // The first lo edges are acyclic, the first hi are not.
+    int lo = 0;
+    int hi = l->n_edges;
+    while (hi - lo > 1) {
+        int mid = lo + (hi - lo) / 2;
+        int res = load_prefix_acyclic(l, mid);
+        if (res < 0) return -1;
+        if (res) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return hi - 1;
+}
+
+/**
+ * Loads an edge list into a graph. The file is read in chunks, each line is
+ * parsed in place, and the edges are added with dag_add_edges_bulk() once
+ * the whole file has been read. See dag.h.
+ */
+int dag_load_edge_list(struct Dag *d, const char *path, char delim,
+                       enum LoadKeys keys, struct EdgeList **loaded,
+                       struct LoadResult *res) {
+    DAG_STAT_CALL(d, DAG_API_LOAD_EDGE_LIST);
+    struct LoadResult r;
+    memset(&r, 0, sizeof(r));
+    if (res) *res = r;
+    if (loaded) *loaded = NULL;
+    if (!d || !path || !loaded) return -1;
+
+    double start = load_now();
+    struct EdgeList *l = calloc(1, sizeof(*l));
+    if (!l) return -1;
+    l->d = d;
+    l->keys = keys;
+    l->arena = arena_create(LOAD_BLOCK);
+    *loaded = l;
+
+    FILE *f = fopen(path, "rb");
+    size_t buf_cap = LOAD_CHUNK;
+    char *buf = malloc(buf_cap);
+    bool ok = f && l->arena && buf;
+    size_t kept = 0;
+    bool eof = false;
+
+    while (ok && !eof) {
+        // Read the next chunk after the unfinished line of the last one.
+        size_t got = fread(buf + kept, 1, buf_cap - kept, f);
+        size_t size = kept + got;
+        r.bytes += got;
+        eof = got < buf_cap - kept;
+        if (eof && ferror(f)) {
+            ok = false;
+            break;
+        }
+
+        size_t pos = 0;
+        while (pos < size) {
+            char *nl = memchr(buf + pos, '\n', size - pos);
+            if (nl == NULL && !eof) break;
+
+            size_t len = (nl ? (size_t) (nl - buf) : size) - pos;
+            r.lines++;
+            if (load_line(l, buf + pos, len, delim, r.lines) != 0) {
+                r.error_line = r.lines;
+                ok = false;
+                break;
+            }
+            pos += len + (nl != NULL);
+        }
+
+        kept = size - pos;
+        memmove(buf, buf + pos, kept);
+        if (ok && kept == buf_cap) {
+            // A single line longer than the buffer.
+            char *bigger = realloc(buf, 2 * buf_cap);
+            if (!bigger) {
+                ok = false;
+                break;
+            }
+            buf = bigger;
+            buf_cap *= 2;
+        }
+    }
+    free(buf);
+    if (f) fclose(f);
+
+    if (ok) {
+        int n_cyclic = 0;
+        int *cyclic = malloc((l->n_edges + 1) * sizeof(*cyclic));
+        ok = cyclic != NULL
+             && dag_add_edges_bulk(d, l->from, l->to, l->weights, l->n_edges,
+                                   cyclic, &n_cyclic) == 0;
+        if (!ok && n_cyclic > 0) {
+            int first = load_first_cyclic(l);
+            if (first >= 0) {
+                r.cycle_line = l->lines[first];
+            }
+        }
+        free(cyclic);
+    }
+
+    r.edges = ok ? l->n_edges : 0;
+    r.vertices = (int) l->table_size;
+    r.seconds = load_now() - start;
+    if (r.seconds > 0) {
+        r.lines_per_second = r.lines / r.seconds;
+        r.bytes_per_second = r.bytes / r.seconds;
+    }
+    if (res) *res = r;
+
+    // The pending edges are only needed until they are added.
+    free(l->from);
+    free(l->to);
+    free(l->weights);
+    free(l->lines);
+    l->from = l->to = NULL;
+    l->weights = NULL;
+    l->lines = NULL;
+
+    return ok ? 0 : -1;
+}
+
+/**
+ * Finds the vertex loaded for a key. See dag.h.
+ */
+struct Vertex *dag_edge_list_vertex(struct EdgeList *l, const char *key) {
+    if (!l || !key) return NULL;
+
+    size_t len = strlen(key);
+    int64_t num = 0;
+    uint64_t hash;
+    if (l->keys == KEYS_INTEGER) {
+        if (load_parse_int(key, len, &num) != 0) return NULL;
+        hash = load_hash((const char *) &num, sizeof(num));
+    } else {
+        hash = load_hash(key, len);
+    }
+    return load_find(l, key, len, num, hash);
+}
+
+/**
+ * Frees the keys and weights of a loaded edge list. See dag.h.
+ */
+void dag_edge_list_destroy(struct EdgeList *l) {
+    if (!l) return;
+
+    free(l->from);
+    free(l->to);
+    free(l->weights);
+    free(l->lines);
+    free(l->table);
+    if (l->arena) arena_destroy(l->arena);
+    free(l);
+}
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+// Number of frontier vertices a worker claims at a time.
+#define LEVEL_CHUNK 256
+
+// State shared by the threads computing the topological levels.
+struct LevelWork {
+    struct Dag *d;
+    struct TopoLevels *levels;
+    atomic_int *in_degree;
+    // Workers wait for `started` before entering the level loop, so that
+    // the barrier can be sized by the number of threads actually created.
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    bool started;
+    pthread_barrier_t barrier;
+    // The frontier being expanded is ids[lo, hi), the next one is appended
+    // from tail on.
+    int lo;
+    int hi;
+    atomic_int tail;
+    atomic_int next_chunk;
+    bool done;
+};
+
+struct LevelWorker {
+    struct LevelWork *work;
+    int tid;
+    int *buf;
+};
+
+/**
+ * Expands the current frontier in chunks claimed from a shared counter.
+ * Vertices whose last predecessor is removed are collected in the workers
+ * buffer, which is copied into the next level with one atomic reservation.
+ */
+static void dag_level_expand(struct LevelWorker *w) {
+    struct LevelWork *work = w->work;
+    struct TopoLevels *levels = work->levels;
+    int found = 0;
+
+    for (;;) {
+        int start = work->lo + atomic_fetch_add(&work->next_chunk, LEVEL_CHUNK);
+        if (start >= work->hi) {
+            break;
+        }
+        int end = start + LEVEL_CHUNK < work->hi ? start + LEVEL_CHUNK 
+                                                 : work->hi;
+
+        for (int i = start; i < end; i++) {
+            struct Vertex *v = work->d->vertices[levels->ids[i]];
+            for (int j = 0; j < v->out_size; j++) {
+                int to = v->out[j]->to->id;
+                if (atomic_fetch_sub(&work->in_degree[to], 1) == 1) {
+                    w->buf[found++] = to;
+                }
+            }
+        }
+    }
+
+    if (found > 0) {
+        int pos = atomic_fetch_add(&work->tail, found);
+        memcpy(&levels->ids[pos], w->buf, found * sizeof(*w->buf));
+    }
+}
+
+/**
+ * Runs the level loop on one thread. Thread 0 closes each level between the
+ * two barriers, while the others wait.
+ */
+static void *dag_level_worker(void *arg) {
+    struct LevelWorker *w = arg;
+    struct LevelWork *work = w->work;
+
+    pthread_mutex_lock(&work->lock);
+    while (!work->started) {
+        pthread_cond_wait(&work->start, &work->lock);
+    }
+    pthread_mutex_unlock(&work->lock);
+
+    for (;;) {
+        pthread_barrier_wait(&work->barrier);
+        if (work->done) {
+            break;
+        }
+
+        dag_level_expand(w);
+
+        pthread_barrier_wait(&work->barrier);
+        if (w->tid == 0) {
+            struct TopoLevels *levels = work->levels;
+            work->lo = work->hi;
+            work->hi = atomic_load(&work->tail);
+            atomic_store(&work->next_chunk, 0);
+            if (work->hi == work->lo) {
+                work->done = true;
+            } else {
+                levels->level_start[++levels->n_levels] = work->hi;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Frees the levels returned by dag_topological_levels().
+ */
+void dag_topological_levels_destroy(struct TopoLevels *levels) {
+    if (levels == NULL) {
+        return;
+    }
+
+    free(levels->ids);
+    free(levels->level_start);
+    free(levels);
+}
+
+/**
+ * Partitions the vertices of the graph into topological levels. The first
+ * level holds the vertices without predecessors, and each following level
+ * the vertices whose last predecessor is in the level before. Each level is
+ * expanded in parallel, with in-degrees decremented atomically.
+ * d - graph to order.
+ * n_threads - number of threads to use, including the calling thread.
+ * return - the levels, to be freed with dag_topological_levels_destroy();
+ *          null if an error occurred.
+ */
+struct TopoLevels *dag_topological_levels(struct Dag *d, int n_threads) {
+    DAG_STAT_CALL(d, DAG_API_TOPOLOGICAL_LEVELS);
+    if (!d) return NULL;
+    if (n_threads < 1) n_threads = 1;
+
+    int v_count = d->id;
+    struct TopoLevels *levels = calloc(1, sizeof(*levels));
+    struct LevelWorker *workers = calloc(n_threads, sizeof(*workers));
+    pthread_t *threads = malloc(n_threads * sizeof(*threads));
+    struct LevelWork work;
+
+    work.in_degree = malloc((v_count + 1) * sizeof(*work.in_degree));
+    if (levels) {
+        levels->ids = malloc((v_count + 1) * sizeof(*levels->ids));
+        // There is at most one level per vertex.
+        levels->level_start = malloc((v_count + 1) * sizeof(int));
+    }
+
+    bool ok = levels && levels->ids && levels->level_start && workers 
+              && threads && work.in_degree;
+    for (int t = 0; ok && t < n_threads; t++) {
+        workers[t].buf = malloc((v_count + 1) * sizeof(int));
+        ok = workers[t].buf != NULL;
+    }
+    if (!ok) {
+        for (int t = 0; workers && t < n_threads; t++) {
+            free(workers[t].buf);
+        }
+        dag_topological_levels_destroy(levels);
+        free(work.in_degree);
+        free(workers);
+        free(threads);
+        return NULL;
+    }
+
+    // The sources make up the first level. Removed vertices have no edges,
+    // and are left out.
+    int sources = 0;
+    for (int v = 0; v < v_count; v++) {
+        int in = d->vertices[v]->in_size;
+        atomic_init(&work.in_degree[v], in);
+        if (in == 0 && !d->vertices[v]->removed) {
+            levels->ids[sources++] = v;
+        }
+    }
+
+    work.d = d;
+    work.levels = levels;
+    work.lo = 0;
+    work.hi = sources;
+    atomic_init(&work.tail, sources);
+    atomic_init(&work.next_chunk, 0);
+    work.done = sources == 0;
+    work.started = false;
+    levels->level_start[0] = 0;
+    levels->n_levels = 0;
+    if (sources > 0) {
+        levels->level_start[++levels->n_levels] = sources;
+    }
+
+    pthread_mutex_init(&work.lock, NULL);
+    pthread_cond_init(&work.start, NULL);
+
+    // Use as many of the requested threads as can be created.
+    int n_workers = 1;
+    for (int t = 0; t < n_threads; t++) {
+        workers[t].work = &work;
+        workers[t].tid = t;
+    }
+    for (int t = 1; t < n_threads; t++) {
+        if (pthread_create(&threads[t], NULL, dag_level_worker, 
+                           &workers[t]) != 0) {
+            break;
+        }
+        n_workers++;
+    }
+
+    pthread_barrier_init(&work.barrier, NULL, n_workers);
+    pthread_mutex_lock(&work.lock);
+    work.started = true;
+    pthread_cond_broadcast(&work.start);
+    pthread_mutex_unlock(&work.lock);
+
+    dag_level_worker(&workers[0]);
+
+    for (int t = 1; t < n_workers; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    pthread_barrier_destroy(&work.barrier);
+    pthread_cond_destroy(&work.start);
+    pthread_mutex_destroy(&work.lock);
+
+    levels->n_ids = atomic_load(&work.tail);
+
+    for (int t = 0; t < n_threads; t++) {
+        free(workers[t].buf);
+    }
+    free(work.in_degree);
+    free(workers);
+    free(threads);
+
+    return levels;
+}
@@ -0,0 +1,152 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+// Memory used for the reachability bitsets of one block of target vertices.
+#ifndef REDUCE_BLOCK_BYTES
+#define REDUCE_BLOCK_BYTES ((size_t) 64 << 20)
+#endif
+
+/**
+ * Finds the edges that can be removed without changing which vertices can
+ * reach which. The vertices are split into blocks of consecutive positions
+ * in the topological order, as many as fit in REDUCE_BLOCK_BYTES of
+ * bitsets but at least 64, which takes one word per vertex. For each
+ * block, the vertices ranked before its end are visited in reverse
+ * topological order, and every vertex gets the bitset of the block
+ * vertices it can reach: the union of the bitsets and bits of its
+ * successors. An edge u -> v is redundant exactly when v is in the bitset
+ * of another successor of u.
+ * return - the redundant edges; null if an error occurred.
+ */
+struct Edge **dag_transitive_reduction(struct Dag *d, int *n) {
+    DAG_STAT_CALL(d, DAG_API_TRANSITIVE_REDUCTION);
+    if (n) *n = 0;
+    if (!d || !n) return NULL;
+
+    int v_count;
+    struct Vertex **order = dag_topological_order(d, &v_count);
+    if (order == NULL) return NULL;
+
+    size_t words = (v_count + 63) / 64;
+    size_t block_words = REDUCE_BLOCK_BYTES / sizeof(uint64_t)
+                         / (v_count > 0 ? v_count : 1);
+    if (block_words < 1) block_words = 1;
+    if (block_words > words) block_words = words;
+    int block_size = (int) (64 * block_words);
+
+    int *pos = malloc((d->id + 1) * sizeof(*pos));
+    uint64_t *reach = malloc(((size_t) v_count * block_words + 1)
+                             * sizeof(*reach));
+    // Edges already found redundant, by position in the edge array.
+    bool *found = calloc(d->e_size + 1, sizeof(*found));
+    // The last vertex found with an edge to each vertex.
+    int *last_from = malloc((d->id + 1) * sizeof(*last_from));
+    struct Edge **redundant = malloc((d->e_size + 1) * sizeof(*redundant));
+    if (!pos || !reach || !found || !last_from || !redundant) {
+        free(pos);
+        free(reach);
+        free(found);
+        free(last_from);
+        free(redundant);
+        return NULL;
+    }
+
+    int count = 0;
+    for (int i = 0; i < v_count; i++) {
+        pos[order[i]->id] = i;
+    }
+
+    // Only the first of several parallel edges is needed.
+    for (int i = 0; i < d->id; i++) {
+        last_from[i] = -1;
+    }
+    for (int i = 0; i < v_count; i++) {
+        struct Vertex *u = order[i];
+        for (int j = 0; j < u->out_size; j++) {
+            struct Edge *e = u->out[j];
+            if (last_from[e->to->id] == i) {
+                found[e->index] = true;
+                redundant[count++] = e;
+            }
+            last_from[e->to->id] = i;
+        }
+    }
+
+    for (int lo = 0; lo < v_count; lo += block_size) {
+        int hi = v_count - lo < block_size ? v_count : lo + block_size;
+
+        // Vertices ranked from hi on can not reach the block.
+        for (int i = hi - 1; i >= 0; i--) {
+            struct Vertex *u = order[i];
+            uint64_t *r = &reach[(size_t) i * block_words];
+            memset(r, 0, block_words * sizeof(*r));
+            DAG_STAT_ADD(d, vertices_visited, 1);
+            DAG_STAT_ADD(d, edges_scanned, 2 * u->out_size);
+
+            for (int j = 0; j < u->out_size; j++) {
+                int t = pos[u->out[j]->to->id];
+                if (t < hi) {
+                    dag_bits_or(r, &reach[(size_t) t * block_words],
+                                block_words);
+                }
+            }
+
+            for (int j = 0; j < u->out_size; j++) {
+                struct Edge *e = u->out[j];
+                int t = pos[e->to->id];
+                if (t < lo || t >= hi) {
+                    continue;
+                }
+                int bit = t - lo;
+                if ((r[bit / 64] >> (bit % 64)) & 1) {
+                    if (!found[e->index]) {
+                        found[e->index] = true;
+                        redundant[count++] = e;
+                    }
+                }
+            }
+
+            // Add the successors themselves once the check is done.
+            for (int j = 0; j < u->out_size; j++) {
+                int t = pos[u->out[j]->to->id];
+                if (t >= lo && t < hi) {
+                    r[(t - lo) / 64] |= (uint64_t) 1 << ((t - lo) % 64);
+                }
+            }
+        }
+    }
+
+    free(pos);
+    free(reach);
+    free(found);
+    free(last_from);
+
+    *n = count;
+    return redundant;
+}
+
+/**
+ * Removes the edges found by dag_transitive_reduction().
+ * return - the number of edges removed; -1 if an error occurred.
+ */
+int dag_transitive_reduce(struct Dag *d, bool free_weight) {
+    int n;
+    struct Edge **redundant = dag_transitive_reduction(d, &n);
+    if (redundant == NULL) return -1;
+
+    for (int i = 0; i < n; i++) {
+        dag_unlink_edge(d, redundant[i], true, free_weight);
+    }
+    if (n > 0) {
+        d->version++;
+    }
+
+    free(redundant);
+    return n;
+}
@@ -0,0 +1,602 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "dag.h"
+#include "dag_internal.h"
+
+#define SNAPSHOT_MAGIC "DAGSNAP"
+#define SNAPSHOT_FORMAT 1
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+// How the weights of the vertices or edges are stored.
+enum SnapshotWeightMode {
+    WEIGHTS_NONE,
+    // Fixed size records, one per element.
+    WEIGHTS_INLINE,
+    // Variable size blobs, located by an offset array of n + 1 entries.
+    WEIGHTS_BLOB
+};
+
+// Sections of the file, each starting at an 8 byte aligned offset.
+enum SnapshotSection {
+    SECTION_OUT_OFFSETS,    // uint64_t[n_vertices + 1]
+    SECTION_OUT_TARGETS,    // int32_t[n_edges]
+    SECTION_IN_OFFSETS,     // uint64_t[n_vertices + 1]
+    SECTION_IN_SOURCES,     // int32_t[n_edges]
+    SECTION_IN_EDGES,       // int32_t[n_edges], edge indices
+    SECTION_TOPO_ORDER,     // int32_t[n_vertices]
+    SECTION_V_WEIGHT_OFFSETS,
+    SECTION_V_WEIGHTS,
+    SECTION_E_WEIGHT_OFFSETS,
+    SECTION_E_WEIGHTS,
+    SECTION_COUNT
+};
+
+/*
+ * The file starts with this header. The vertex and edge tables follow in
+ * compressed sparse row layout: the outgoing edges of vertex v are the edges
+ * out_offsets[v] to out_offsets[v + 1] - 1, numbered in vertex id order.
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t format;
+    uint32_t byte_order;
+    int64_t n_vertices;
+    int64_t n_edges;
+    uint32_t v_weight_mode;
+    uint32_t e_weight_mode;
+    uint64_t v_weight_size;
+    uint64_t e_weight_size;
+    uint64_t sections[SECTION_COUNT];
+    uint64_t file_size;
+};
+
+struct DagSnapshot {
+    void *map;
+    size_t map_size;
+    const struct SnapshotHeader *header;
+    const uint64_t *out_offsets;
+    const int32_t *out_targets;
+    const uint64_t *in_offsets;
+    const int32_t *in_sources;
+    const int32_t *in_edges;
+    const int32_t *topo_order;
+    const uint64_t *v_weight_offsets;
+    const char *v_weights;
+    const uint64_t *e_weight_offsets;
+    const char *e_weights;
+};
+
+static uint64_t snapshot_align(uint64_t size) {
+    return (size + 7) & ~(uint64_t) 7;
+}
+
+/**
+ * Writes size bytes, zeros if data is null.
+ * return - 0 on success; -1 on failure.
+ */
+static int snapshot_write_raw(FILE *f, const void *data, size_t size) {
+    static const char zeros[64] = {0};
+
+    if (data != NULL) {
+        return size == 0 || fwrite(data, 1, size, f) == size ? 0 : -1;
+    }
+    while (size > 0) {
+        size_t chunk = size < sizeof(zeros) ? size : sizeof(zeros);
+        if (fwrite(zeros, 1, chunk, f) != chunk) return -1;
+        size -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * Writes size bytes, followed by zeros up to the next 8 byte boundary.
+ * return - 0 on success; -1 on failure.
+ */
+static int snapshot_write(FILE *f, const void *data, size_t size) {
+    if (snapshot_write_raw(f, data, size) != 0) return -1;
+    return snapshot_write_raw(f, NULL, snapshot_align(size) - size);
+}
+
+/**
+ * Returns the serialized form of a weight: the size bytes it points to if
+ * size is non-zero, otherwise the bytes returned by the callback. Missing
+ * weights are returned as null, to be stored as len zeros.
+ */
+static const void *snapshot_weight_bytes(void *w, size_t size,
+                                         weight_bytes_func bytes,
+                                         size_t *len) {
+    if (size > 0) {
+        *len = size;
+        return w;
+    }
+    *len = 0;
+    return w == NULL ? NULL : bytes(w, len);
+}
+
+/**
+ * Computes the layout of the weights of n vertices or edges, filling in the
+ * blob offsets in the blob mode.
+ * return - the size of the weight section.
+ */
+static uint64_t snapshot_weight_layout(void **weights, int n,
+                                       enum SnapshotWeightMode mode,
+                                       size_t size, weight_bytes_func bytes,
+                                       uint64_t *offsets) {
+    if (mode == WEIGHTS_NONE) return 0;
+    if (mode == WEIGHTS_INLINE) return snapshot_align((uint64_t) n * size);
+
+    offsets[0] = 0;
+    for (int i = 0; i < n; i++) {
+        size_t len;
+        snapshot_weight_bytes(weights[i], 0, bytes, &len);
+        offsets[i + 1] = offsets[i] + len;
+    }
+    return snapshot_align((n + 1) * sizeof(*offsets))
+           + snapshot_align(offsets[n]);
+}
+
+/**
+ * Writes the weight section laid out by snapshot_weight_layout().
+ * return - 0 on success; -1 on failure.
+ */
+static int snapshot_write_weights(FILE *f, void **weights, int n,
+                                  enum SnapshotWeightMode mode, size_t size,
+                                  weight_bytes_func bytes, 
+                                  const uint64_t *offsets) {
+    if (mode == WEIGHTS_NONE) return 0;
+
+    if (mode == WEIGHTS_BLOB 
+            && snapshot_write(f, offsets, (n + 1) * sizeof(*offsets)) != 0) {
+        return -1;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < n; i++) {
+        size_t len;
+        const void *data = snapshot_weight_bytes(weights[i], size, bytes, 
+                                                 &len);
+        if (snapshot_write_raw(f, data, len) != 0) return -1;
+        total += len;
+    }
+    return snapshot_write_raw(f, NULL, snapshot_align(total) - total);
+}
+
+/**
+ * Saves the graph to a file that dag_open_mmap() can map. The vertices keep
+ * their ids, and the edges are numbered by source vertex, in the order of
+ * dag_v_get_out_edge().
+ * d - graph to save.
+ * path - file to write.
+ * v_weight_size - if non-zero, vertex weights are stored inline, by copying
+ *                 this many bytes from each weight pointer.
+ * e_weight_size - the same, for edge weights.
+ * v_bytes - if v_weight_size is zero and this is not null, serializes each
+ *           vertex weight. Otherwise vertex weights are not stored.
+ * e_bytes - the same, for edge weights.
+ * return - 0 on success; -1 if an error occurred.
+ */
+int dag_save(struct Dag *d, const char *path,
+             size_t v_weight_size, size_t e_weight_size,
+             weight_bytes_func v_bytes, weight_bytes_func e_bytes) {
+    DAG_STAT_CALL(d, DAG_API_SAVE);
+    if (!d || !path) return -1;
+
+    int n = d->id;
+    int m = d->e_size;
+    struct SnapshotHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    h.format = SNAPSHOT_FORMAT;
+    h.byte_order = SNAPSHOT_BYTE_ORDER;
+    h.n_vertices = n;
+    h.n_edges = m;
+    h.v_weight_mode = v_weight_size > 0 ? WEIGHTS_INLINE
+                    : v_bytes ? WEIGHTS_BLOB : WEIGHTS_NONE;
+    h.e_weight_mode = e_weight_size > 0 ? WEIGHTS_INLINE
+                    : e_bytes ? WEIGHTS_BLOB : WEIGHTS_NONE;
+    h.v_weight_size = v_weight_size;
+    h.e_weight_size = e_weight_size;
+
+    struct Vertex **order = dag_topological_order(d, NULL);
+    uint64_t *out_offsets = malloc((n + 1) * sizeof(*out_offsets));
+    uint64_t *in_offsets = malloc((n + 1) * sizeof(*in_offsets));
+    int32_t *out_targets = malloc((m + 1) * sizeof(*out_targets));
+    int32_t *in_sources = malloc((m + 1) * sizeof(*in_sources));
+    int32_t *in_edges = malloc((m + 1) * sizeof(*in_edges));
+    int32_t *topo_order = malloc((n + 1) * sizeof(*topo_order));
+    void **v_weights = malloc((n + 1) * sizeof(*v_weights));
+    void **e_weights = malloc((m + 1) * sizeof(*e_weights));
+    uint64_t *v_offsets = malloc((n + 1) * sizeof(*v_offsets));
+    uint64_t *e_offsets = malloc((m + 1) * sizeof(*e_offsets));
+    int res = -1;
+
+    if (!order || !out_offsets || !in_offsets || !out_targets || !in_sources
+            || !in_edges || !topo_order || !v_weights || !e_weights 
+            || !v_offsets || !e_offsets) {
+        goto out;
+    }
+
+    out_offsets[0] = 0;
+    in_offsets[0] = 0;
+    for (int v = 0; v < n; v++) {
+        struct Vertex *vx = d->vertices[v];
+        out_offsets[v + 1] = out_offsets[v] + vx->out_size;
+        in_offsets[v + 1] = in_offsets[v] + vx->in_size;
+        v_weights[v] = vx->weight;
+        topo_order[v] = order[v]->id;
+
+        for (int j = 0; j < vx->out_size; j++) {
+            out_targets[out_offsets[v] + j] = vx->out[j]->to->id;
+            e_weights[out_offsets[v] + j] = vx->out[j]->weight;
+        }
+    }
+
+    // Scatter the edges on their targets, using the start of the in-range of
+    // each vertex as its cursor. Afterwards each cursor has reached the start
+    // of the next range, so shifting the array by one restores it.
+    for (int v = 0; v < n; v++) {
+        for (uint64_t e = out_offsets[v]; e < out_offsets[v + 1]; e++) {
+            uint64_t pos = in_offsets[out_targets[e]]++;
+            in_sources[pos] = v;
+            in_edges[pos] = (int32_t) e;
+        }
+    }
+    memmove(&in_offsets[1], &in_offsets[0], n * sizeof(*in_offsets));
+    in_offsets[0] = 0;
+
+    uint64_t sizes[SECTION_COUNT] = {
+        [SECTION_OUT_OFFSETS] = (n + 1) * sizeof(uint64_t),
+        [SECTION_OUT_TARGETS] = m * sizeof(int32_t),
+        [SECTION_IN_OFFSETS] = (n + 1) * sizeof(uint64_t),
+        [SECTION_IN_SOURCES] = m * sizeof(int32_t),
+        [SECTION_IN_EDGES] = m * sizeof(int32_t),
+        [SECTION_TOPO_ORDER] = n * sizeof(int32_t),
+        [SECTION_V_WEIGHTS] = snapshot_weight_layout(v_weights, n, 
+                h.v_weight_mode, v_weight_size, v_bytes, v_offsets),
+        [SECTION_E_WEIGHTS] = snapshot_weight_layout(e_weights, m, 
+                h.e_weight_mode, e_weight_size, e_bytes, e_offsets)
+    };
+    uint64_t pos = snapshot_align(sizeof(h));
+    for (int s = 0; s < SECTION_COUNT; s++) {
+        h.sections[s] = pos;
+        pos += snapshot_align(sizes[s]);
+    }
+    // Blobs follow their offset arrays.
+    if (h.v_weight_mode == WEIGHTS_BLOB) {
+        h.sections[SECTION_V_WEIGHT_OFFSETS] = h.sections[SECTION_V_WEIGHTS];
+        h.sections[SECTION_V_WEIGHTS] += snapshot_align((n + 1) * sizeof(uint64_t));
+    }
+    if (h.e_weight_mode == WEIGHTS_BLOB) {
+        h.sections[SECTION_E_WEIGHT_OFFSETS] = h.sections[SECTION_E_WEIGHTS];
+        h.sections[SECTION_E_WEIGHTS] += snapshot_align((m + 1) * sizeof(uint64_t));
+    }
+    h.file_size = pos;
+
+    FILE *f = fopen(path, "wb");
+    if (f == NULL) goto out;
+
+    res = snapshot_write(f, &h, sizeof(h))
+          || snapshot_write(f, out_offsets, sizes[SECTION_OUT_OFFSETS])
+          || snapshot_write(f, out_targets, sizes[SECTION_OUT_TARGETS])
+          || snapshot_write(f, in_offsets, sizes[SECTION_IN_OFFSETS])
+          || snapshot_write(f, in_sources, sizes[SECTION_IN_SOURCES])
+          || snapshot_write(f, in_edges, sizes[SECTION_IN_EDGES])
+          || snapshot_write(f, topo_order, sizes[SECTION_TOPO_ORDER])
+          || snapshot_write_weights(f, v_weights, n, h.v_weight_mode,
+                                    v_weight_size, v_bytes, v_offsets)
+          || snapshot_write_weights(f, e_weights, m, h.e_weight_mode,
+                                    e_weight_size, e_bytes, e_offsets)
+          ? -1 : 0;
+
+    if (fclose(f) != 0) {
+        res = -1;
+    }
+
+out:
+    free(out_offsets);
+    free(in_offsets);
+    free(out_targets);
+    free(in_sources);
+    free(in_edges);
+    free(topo_order);
+    free(v_weights);
+    free(e_weights);
+    free(v_offsets);
+    free(e_offsets);
+
+    return res;
+}
+
+/**
+ * Checks that count elements of size bytes, starting at section s, lie
+ * within the file. The header has been checked to match the file size.
+ */
+static bool snapshot_section_fits(const struct SnapshotHeader *h, int s,
+                                  uint64_t count, uint64_t size) {
+    uint64_t start = h->sections[s];
+    if (start % 8 != 0 || start < sizeof(*h) || start > h->file_size) {
+        return false;
+    }
+    // Dividing the space left can not overflow, as multiplying could.
+    return size == 0 || count <= (h->file_size - start) / size;
+}
+
+/**
+ * Checks that the weights of count vertices or edges lie within the file.
+ * Blobs end where the last entry of their offset array says, which is the
+ * only part of the tables read.
+ */
+static bool snapshot_weights_fit(const struct SnapshotHeader *h,
+                                 const char *base, int offsets_section,
+                                 int weights_section, uint32_t mode,
+                                 uint64_t size, uint64_t count) {
+    switch (mode) {
+        case WEIGHTS_NONE:
+            return true;
+        case WEIGHTS_INLINE:
+            return snapshot_section_fits(h, weights_section, count, size);
+        case WEIGHTS_BLOB: {
+            if (!snapshot_section_fits(h, offsets_section, count + 1, 
+                                       sizeof(uint64_t))) {
+                return false;
+            }
+            const uint64_t *offsets = 
+                (const uint64_t *) (base + h->sections[offsets_section]);
+            return snapshot_section_fits(h, weights_section, offsets[count], 
+                                         1);
+        }
+        default:
+            return false;
+    }
+}
+
+/**
+ * Checks the header of a mapped file, and that every section it describes
+ * lies within the file.
+ */
+static bool snapshot_check_header(const char *base, uint64_t file_size) {
+    const struct SnapshotHeader *h = (const struct SnapshotHeader *) base;
+    if (memcmp(h->magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+            || h->format != SNAPSHOT_FORMAT
+            || h->byte_order != SNAPSHOT_BYTE_ORDER
+            || h->file_size != file_size
+            || h->n_vertices < 0 || h->n_vertices >= INT32_MAX
+            || h->n_edges < 0 || h->n_edges >= INT32_MAX) {
+        return false;
+    }
+
+    uint64_t n = h->n_vertices;
+    uint64_t m = h->n_edges;
+    return snapshot_section_fits(h, SECTION_OUT_OFFSETS, n + 1, 
+                                 sizeof(uint64_t))
+           && snapshot_section_fits(h, SECTION_OUT_TARGETS, m, 
+                                    sizeof(int32_t))
+           && snapshot_section_fits(h, SECTION_IN_OFFSETS, n + 1, 
+                                    sizeof(uint64_t))
+           && snapshot_section_fits(h, SECTION_IN_SOURCES, m, 
+                                    sizeof(int32_t))
+           && snapshot_section_fits(h, SECTION_IN_EDGES, m, sizeof(int32_t))
+           && snapshot_section_fits(h, SECTION_TOPO_ORDER, n, 
+                                    sizeof(int32_t))
+           && snapshot_weights_fit(h, base, SECTION_V_WEIGHT_OFFSETS,
+                                   SECTION_V_WEIGHTS, h->v_weight_mode,
+                                   h->v_weight_size, n)
+           && snapshot_weights_fit(h, base, SECTION_E_WEIGHT_OFFSETS,
+                                   SECTION_E_WEIGHTS, h->e_weight_mode,
+                                   h->e_weight_size, m);
+}
+
+/**
+ * Maps a file written by dag_save() into memory. Only the header, and the
+ * blob sizes, are read up front, so pages of the tables are loaded as they
+ * are first touched. Their contents are trusted; see dag_snapshot_verify().
+ * path - file to map.
+ * return - the read-only graph, to be closed with dag_snapshot_close(); null
+ *          if the file could not be mapped or is not a snapshot.
+ */
+struct DagSnapshot *dag_open_mmap(const char *path) {
+    if (!path) return NULL;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t) st.st_size < sizeof(struct SnapshotHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return NULL;
+
+    const struct SnapshotHeader *h = map;
+    bool ok = snapshot_check_header(map, st.st_size);
+
+    struct DagSnapshot *snap = ok ? malloc(sizeof(*snap)) : NULL;
+    if (snap == NULL) {
+        munmap(map, st.st_size);
+        return NULL;
+    }
+
+    const char *base = map;
+    snap->map = map;
+    snap->map_size = st.st_size;
+    snap->header = h;
+    snap->out_offsets = (const uint64_t *) (base + h->sections[SECTION_OUT_OFFSETS]);
+    snap->out_targets = (const int32_t *) (base + h->sections[SECTION_OUT_TARGETS]);
+    snap->in_offsets = (const uint64_t *) (base + h->sections[SECTION_IN_OFFSETS]);
+    snap->in_sources = (const int32_t *) (base + h->sections[SECTION_IN_SOURCES]);
+    snap->in_edges = (const int32_t *) (base + h->sections[SECTION_IN_EDGES]);
+    snap->topo_order = (const int32_t *) (base + h->sections[SECTION_TOPO_ORDER]);
+    snap->v_weight_offsets = (const uint64_t *) (base + h->sections[SECTION_V_WEIGHT_OFFSETS]);
+    snap->v_weights = base + h->sections[SECTION_V_WEIGHTS];
+    snap->e_weight_offsets = (const uint64_t *) (base + h->sections[SECTION_E_WEIGHT_OFFSETS]);
+    snap->e_weights = base + h->sections[SECTION_E_WEIGHTS];
+
+    return snap;
+}
+
+/**
+ * Checks that an offset array of n + 1 entries starts at 0, never
+ * decreases, and ends at total.
+ */
+static bool snapshot_offsets_ok(const uint64_t *offsets, uint64_t n,
+                                uint64_t total) {
+    if (offsets[0] != 0 || offsets[n] != total) return false;
+    for (uint64_t i = 0; i < n; i++) {
+        if (offsets[i] > offsets[i + 1]) return false;
+    }
+    return true;
+}
+
+/**
+ * Checks that count ids are at least 0 and less than limit.
+ */
+static bool snapshot_ids_ok(const int32_t *ids, uint64_t count, 
+                            int64_t limit) {
+    for (uint64_t i = 0; i < count; i++) {
+        if (ids[i] < 0 || ids[i] >= limit) return false;
+    }
+    return true;
+}
+
+/**
+ * Checks every offset and id of a mapped graph, in one pass over the file.
+ * return - 0 if the tables are consistent; -1 otherwise.
+ */
+int dag_snapshot_verify(struct DagSnapshot *s) {
+    if (s == NULL) return -1;
+
+    const struct SnapshotHeader *h = s->header;
+    uint64_t n = h->n_vertices;
+    uint64_t m = h->n_edges;
+    bool ok = snapshot_offsets_ok(s->out_offsets, n, m)
+              && snapshot_offsets_ok(s->in_offsets, n, m)
+              && snapshot_ids_ok(s->out_targets, m, h->n_vertices)
+              && snapshot_ids_ok(s->in_sources, m, h->n_vertices)
+              && snapshot_ids_ok(s->in_edges, m, h->n_edges)
+              && snapshot_ids_ok(s->topo_order, n, h->n_vertices);
+    // The blob ends were checked against the file when it was opened.
+    if (ok && h->v_weight_mode == WEIGHTS_BLOB) {
+        ok = snapshot_offsets_ok(s->v_weight_offsets, n, 
+                                 s->v_weight_offsets[n]);
+    }
+    if (ok && h->e_weight_mode == WEIGHTS_BLOB) {
+        ok = snapshot_offsets_ok(s->e_weight_offsets, m, 
+                                 s->e_weight_offsets[m]);
+    }
+
+    return ok ? 0 : -1;
+}
+
+/**
+ * Unmaps a snapshot opened by dag_open_mmap(). Pointers obtained from it are
+ * no longer valid.
+ */
+void dag_snapshot_close(struct DagSnapshot *s) {
+    if (s == NULL) return;
+
+    munmap(s->map, s->map_size);
+    free(s);
+}
+
+/**
+ * Gets the number of vertices in a mapped graph.
+ */
+int dag_snapshot_vertex_count(struct DagSnapshot *s) {
+    return (int) s->header->n_vertices;
+}
+
+/**
+ * Gets the number of edges in a mapped graph.
+ */
+int dag_snapshot_edge_count(struct DagSnapshot *s) {
+    return (int) s->header->n_edges;
+}
+
+/**
+ * Returns the successors of vertex id, which are the targets of the edges
+ * first to first + n - 1.
+ */
+const int32_t *dag_snapshot_successors(struct DagSnapshot *s, int id,
+                                       int *n, int *first) {
+    uint64_t lo = s->out_offsets[id];
+    *n = (int) (s->out_offsets[id + 1] - lo);
+    if (first) *first = (int) lo;
+    return &s->out_targets[lo];
+}
+
+/**
+ * Returns the predecessors of vertex id, and the indices of the edges from 
+ * them in the same order.
+ */
+const int32_t *dag_snapshot_predecessors(struct DagSnapshot *s, int id,
+                                         int *n, const int32_t **edges) {
+    uint64_t lo = s->in_offsets[id];
+    *n = (int) (s->in_offsets[id + 1] - lo);
+    if (edges) *edges = &s->in_edges[lo];
+    return &s->in_sources[lo];
+}
+
+/**
+ * Gets the target vertex of an edge in a mapped graph.
+ */
+int dag_snapshot_e_get_to(struct DagSnapshot *s, int e) {
+    return s->out_targets[e];
+}
+
+/**
+ * Gets the topological order stored with a mapped graph.
+ */
+const int32_t *dag_snapshot_topological_order(struct DagSnapshot *s, int *n) {
+    if (n) *n = (int) s->header->n_vertices;
+    return s->topo_order;
+}
+
+/**
+ * Locates weight i in a weight section.
+ */
+static const void *snapshot_weight(const char *weights, 
+                                   const uint64_t *offsets, uint32_t mode,
+                                   uint64_t size, int i, size_t *len) {
+    switch (mode) {
+        case WEIGHTS_INLINE:
+            if (len) *len = size;
+            return weights + (uint64_t) i * size;
+        case WEIGHTS_BLOB:
+            if (len) *len = offsets[i + 1] - offsets[i];
+            return weights + offsets[i];
+        default:
+            if (len) *len = 0;
+            return NULL;
+    }
+}
+
+/**
+ * Gets the weight of a vertex in a mapped graph.
+ */
+const void *dag_snapshot_v_get_weight(struct DagSnapshot *s, int id, 
+                                      size_t *len) {
+    return snapshot_weight(s->v_weights, s->v_weight_offsets,
+                           s->header->v_weight_mode, s->header->v_weight_size,
+                           id, len);
+}
+
+/**
+ * Gets the weight of an edge in a mapped graph.
+ */
+const void *dag_snapshot_e_get_weight(struct DagSnapshot *s, int e, 
+                                      size_t *len) {
+    return snapshot_weight(s->e_weights, s->e_weight_offsets,
+                           s->header->e_weight_mode, s->header->e_weight_size,
+                           e, len);
+}
@@ -0,0 +1,86 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "arena.h"
+#include "dag.h"
+#include "dag_internal.h"
+
+#ifdef DAG_STATS
+static uint64_t dag_stat_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+/**
+ * Starts timing a call of an API function. Used through DAG_STAT_CALL().
+ */
+struct DagStatCall dag_stat_call_begin(struct Dag *d, enum DagApi api) {
+    struct DagStatCall call = {d, api, d ? dag_stat_now() : 0};
+    return call;
+}
+
+/**
+ * Counts a call of an API function and its time, when the scope holding the
+ * DAG_STAT_CALL() is left.
+ */
+void dag_stat_call_end(struct DagStatCall *call) {
+    if (call->d == NULL) {
+        return;
+    }
+
+    call->d->stats.calls[call->api]++;
+    call->d->stats.nanoseconds[call->api] += dag_stat_now() - call->start;
+}
+
+/**
+ * Computes the bytes held by the dag besides its vertices, edges and 
+ * adjacency arrays: the dag itself and the arrays indexed by vertex id.
+ */
+static uint64_t dag_stat_table_bytes(struct Dag *d) {
+    uint64_t bytes = sizeof(*d);
+    bytes += (uint64_t) d->v_cap * sizeof(*d->vertices);
+    bytes += (uint64_t) d->e_cap * sizeof(*d->edges);
+    bytes += (uint64_t) d->edge_table_cap * sizeof(*d->edge_table);
+    bytes += 2 * ((uint64_t) (d->search_cap + 63) / 64 * sizeof(uint64_t)
+                  + (uint64_t) d->search_cap * sizeof(struct Vertex *));
+    bytes += (uint64_t) d->topo_order_cap * sizeof(*d->topo_order);
+    bytes += dag_reach_index_memory(d);
+    return bytes;
+}
+#endif
+
+/**
+ * Gets the operation counters of the graph. See dag.h.
+ */
+int dag_stats_get(struct Dag *d, struct DagStats *stats) {
+    if (!stats) return -1;
+    memset(stats, 0, sizeof(*stats));
+    if (!d) return -1;
+
+#ifdef DAG_STATS
+    *stats = d->stats;
+    // In an arena the elements take up the slabs holding them.
+    stats->bytes_live = d->arena ? arena_bytes(d->arena) : d->stats.bytes_live;
+    stats->bytes_live += dag_stat_table_bytes(d);
+    return 0;
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Resets the operation counters of the graph. See dag.h.
+ */
+void dag_stats_reset(struct Dag *d) {
+    if (!d) return;
+
+#ifdef DAG_STATS
+    uint64_t bytes_live = d->stats.bytes_live;
+    memset(&d->stats, 0, sizeof(d->stats));
+    d->stats.bytes_live = bytes_live;
+#endif
+}
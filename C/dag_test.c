@@ -1,8 +1,16 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "dag.h"
+#include "queue.h"
+#include "arena.h"
+#include "dag_typed.h"
 
 void test_connected(void);
 void test_connected_large(void);
@@ -13,6 +21,31 @@ void test_longest_path_large(void);
 void test_topological_ordering(void);
 void test_small_topological_ordering(void);
 void test_topological_ordering_large(void);
+void test_successors_predecessors(void);
+void test_longest_path_with_path(void);
+void test_topo_rank(void);
+void test_reachable_bidirectional(void);
+void test_reach_index(void);
+void test_duplicate_edges(void);
+void test_arena_alloc(void);
+void test_queue(void);
+void test_typed_dag(void);
+void test_foreach_path(void);
+void test_count_paths(void);
+void test_add_edges_bulk(void);
+void test_topological_levels(void);
+void test_execute(void);
+void test_topological_order_cache(void);
+void test_paths_from(void);
+void test_snapshot(void);
+void test_load_edge_list(void);
+void test_stats(void);
+void test_shared(void);
+void test_builder(void);
+void test_remove(void);
+void test_transitive_reduction(void);
+void test_closure(void);
+void test_arena_churn(void);
 
 int main(void) {
     test_no_cycles();
@@ -23,6 +56,31 @@ int main(void) {
     test_longest_path_large();
     test_small_topological_ordering();
     test_topological_ordering_large();
+    test_successors_predecessors();
+    test_longest_path_with_path();
+    test_topo_rank();
+    test_reachable_bidirectional();
+    test_reach_index();
+    test_duplicate_edges();
+    test_arena_alloc();
+    test_queue();
+    test_typed_dag();
+    test_foreach_path();
+    test_count_paths();
+    test_add_edges_bulk();
+    test_topological_levels();
+    test_execute();
+    test_topological_order_cache();
+    test_paths_from();
+    test_snapshot();
+    test_load_edge_list();
+    test_stats();
+    test_shared();
+    test_builder();
+    test_remove();
+    test_transitive_reduction();
+    test_closure();
+    test_arena_churn();
     
     return 0;
 }
@@ -373,4 +431,1679 @@ void test_topological_ordering_large(void) {
     dag_destroy_path(ordering);
     dag_destroy(d, false);
     
-}
\ No newline at end of file
+}
+
+void test_successors_predecessors(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w1 = 1, w2 = 2;
+    struct Vertex *A = dag_add_vertex(d, &w1);
+    struct Vertex *B = dag_add_vertex(d, &w1);
+    struct Vertex *C = dag_add_vertex(d, &w1);
+    struct Vertex *D = dag_add_vertex(d, &w1);
+
+    int res = dag_add_edge(d, A, B, &w1);
+    res -= dag_add_edge(d, A, C, &w2);
+    res -= dag_add_edge(d, B, D, &w1);
+    res -= dag_add_edge(d, C, D, &w1);
+
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - Could not add edge\n");
+    }
+
+    if (dag_v_get_out_degree(A) != 2 || dag_v_get_in_degree(A) != 0) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - wrong degree of A\n");
+    }
+    if (dag_v_get_out_degree(D) != 0 || dag_v_get_in_degree(D) != 2) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - wrong degree of D\n");
+    }
+    if (dag_v_get_successor(A, 0) != B || dag_v_get_successor(A, 1) != C) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - wrong successors\n");
+    }
+    if (dag_v_get_predecessor(D, 0) != B || dag_v_get_predecessor(D, 1) != C) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - wrong predecessors\n");
+    }
+    if (dag_v_get_successor(A, 2) != NULL || dag_v_get_predecessor(A, 0) != NULL) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - out of range\n");
+    }
+
+    struct Edge *e = dag_v_get_out_edge(A, 1);
+    if (e != dag_find_edge(d, A, C) || dag_e_get_from(e) != A 
+            || dag_e_get_to(e) != C || dag_e_get_weight(e) != &w2) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - wrong edge\n");
+    }
+    if (dag_find_edge(d, B, C) != NULL) {
+        fprintf(stderr, "ERROR: test_successors_predecessors - found missing edge\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+// Same graph as test_longest_path_large
+void test_longest_path_with_path(void) {
+    struct Dag *d = dag_create(add_ints, int_compare);
+
+    int vw[] = {1, 2, 2, 6, 5, 15, 20, 25};
+    struct Vertex *A = dag_add_vertex(d, &vw[0]);
+    struct Vertex *B = dag_add_vertex(d, &vw[1]);
+    struct Vertex *C = dag_add_vertex(d, &vw[2]);
+    struct Vertex *D = dag_add_vertex(d, &vw[3]);
+    struct Vertex *E = dag_add_vertex(d, &vw[4]);
+    struct Vertex *F = dag_add_vertex(d, &vw[5]);
+    struct Vertex *G = dag_add_vertex(d, &vw[6]);
+    struct Vertex *H = dag_add_vertex(d, &vw[7]);
+
+    int ew[] = {1, 2, 2, 5, 6, 3, 2, 7, 8, 4};
+    int res = dag_add_edge(d, A, B, &ew[0]); 
+    res -= dag_add_edge(d, A, D, &ew[1]); 
+    res -= dag_add_edge(d, B, C, &ew[2]); 
+    res -= dag_add_edge(d, B, D, &ew[3]); 
+    res -= dag_add_edge(d, B, E, &ew[4]); 
+    res -= dag_add_edge(d, C, E, &ew[5]); 
+    res -= dag_add_edge(d, C, H, &ew[6]); 
+    res -= dag_add_edge(d, D, E, &ew[7]); 
+    res -= dag_add_edge(d, E, F, &ew[8]); 
+    res -= dag_add_edge(d, E, G, &ew[9]); 
+
+    // The longest path is a -> b -> d -> e -> g with weight 51.
+    int expected[] = {0, 1, 3, 4, 6};
+    struct list *path;
+    int *weight = dag_longest_path(d, A, G, get_int, get_int, &path);
+
+    if (weight == NULL || *weight != 51) {
+        fprintf(stderr, "ERROR: test_longest_path_with_path - wrong weight\n");
+    }
+
+    int i = 0;
+    struct node *it = list_first(path);
+    while (it != NULL) {
+        if (i >= 5 || dag_v_get_id(it->value) != expected[i]) {
+            fprintf(stderr, "ERROR: test_longest_path_with_path - wrong path\n");
+            break;
+        }
+        i++;
+        it = list_next(it);
+    }
+    if (i != 5) {
+        fprintf(stderr, "ERROR: test_longest_path_with_path - wrong length\n");
+    }
+
+    // H can not be reached from D
+    struct list *no_path;
+    if (dag_longest_path(d, D, H, get_int, get_int, &no_path) != NULL 
+            || no_path != NULL) {
+        fprintf(stderr, "ERROR: test_longest_path_with_path - found missing path\n");
+    }
+
+    free(weight);
+    dag_destroy_path(path);
+    dag_destroy(d, false);
+}
+
+void test_topo_rank(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w = 1;
+    struct Vertex *v[6];
+    for (int i = 0; i < 6; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+
+    // Build the chain 5 -> 4 -> ... -> 0 against the initial order, plus
+    // a few shortcuts, so that every insert has to reorder.
+    int res = 0;
+    for (int i = 5; i > 0; i--) {
+        res -= dag_add_edge(d, v[i], v[i - 1], &w);
+    }
+    res -= dag_add_edge(d, v[5], v[2], &w);
+    res -= dag_add_edge(d, v[3], v[0], &w);
+
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_topo_rank - Could not add edge\n");
+    }
+
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < dag_v_get_out_degree(v[i]); j++) {
+            struct Vertex *to = dag_v_get_successor(v[i], j);
+            if (dag_v_get_topo_rank(v[i]) >= dag_v_get_topo_rank(to)) {
+                fprintf(stderr, "ERROR: test_topo_rank - invalid order\n");
+            }
+        }
+    }
+
+    if (dag_add_edge(d, v[0], v[5], &w) != -1) {
+        fprintf(stderr, "ERROR: test_topo_rank - Graph allows cycles!\n");
+    }
+    if (dag_add_edge(d, v[1], v[3], &w) != -1) {
+        fprintf(stderr, "ERROR: test_topo_rank - Graph allows cycles!\n");
+    }
+    if (dag_add_edge(d, v[2], v[2], &w) != -1) {
+        fprintf(stderr, "ERROR: test_topo_rank - Graph allows self loops!\n");
+    }
+    if (dag_is_connected(d, v[0], v[5]) != 0) {
+        fprintf(stderr, "ERROR: test_topo_rank - rejected edge was added\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_reachable_bidirectional(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    // A lattice of diamonds: every vertex in a layer has an edge to both
+    // vertices in the next layer, plus a vertex X that is only reached
+    // from the first layer.
+    int w = 1;
+    struct Vertex *layers[10][2];
+    for (int i = 0; i < 10; i++) {
+        layers[i][0] = dag_add_vertex(d, &w);
+        layers[i][1] = dag_add_vertex(d, &w);
+    }
+    struct Vertex *X = dag_add_vertex(d, &w);
+
+    int res = 0;
+    for (int i = 0; i < 9; i++) {
+        for (int j = 0; j < 2; j++) {
+            res -= dag_add_edge(d, layers[i][j], layers[i + 1][0], &w);
+            res -= dag_add_edge(d, layers[i][j], layers[i + 1][1], &w);
+        }
+    }
+    res -= dag_add_edge(d, layers[0][0], X, &w);
+
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_reachable_bidirectional - Could not add edge\n");
+    }
+
+    struct Vertex *first = layers[0][0];
+    struct Vertex *last = layers[9][1];
+    enum SearchMode modes[] = {SEARCH_FORWARD, SEARCH_BIDIRECTIONAL};
+
+    for (int m = 0; m < 2; m++) {
+        if (dag_reachable(d, first, last, modes[m]) != 1) {
+            fprintf(stderr, "ERROR: test_reachable_bidirectional - not connected\n");
+        }
+        if (dag_reachable(d, first, X, modes[m]) != 1) {
+            fprintf(stderr, "ERROR: test_reachable_bidirectional - not connected\n");
+        }
+        if (dag_reachable(d, last, first, modes[m]) != 0) {
+            fprintf(stderr, "ERROR: test_reachable_bidirectional - connected\n");
+        }
+        if (dag_reachable(d, layers[1][0], X, modes[m]) != 0) {
+            fprintf(stderr, "ERROR: test_reachable_bidirectional - connected\n");
+        }
+        if (dag_reachable(d, layers[5][0], layers[5][1], modes[m]) != 0) {
+            fprintf(stderr, "ERROR: test_reachable_bidirectional - connected\n");
+        }
+    }
+
+    dag_destroy(d, false);
+}
+
+// Based on the same graph as test_connected_large
+void test_reach_index(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w = 1;
+    struct Vertex *A = dag_add_vertex(d, &w);
+    struct Vertex *B = dag_add_vertex(d, &w);
+    struct Vertex *C = dag_add_vertex(d, &w);
+    struct Vertex *D = dag_add_vertex(d, &w);
+    struct Vertex *F = dag_add_vertex(d, &w);
+    struct Vertex *G = dag_add_vertex(d, &w);
+    struct Vertex *I = dag_add_vertex(d, &w);
+
+    int res = dag_add_edge(d, A, D, &w); 
+    res -= dag_add_edge(d, A, C, &w); 
+    res -= dag_add_edge(d, B, D, &w); 
+    res -= dag_add_edge(d, D, F, &w); 
+    res -= dag_add_edge(d, D, G, &w); 
+    res -= dag_add_edge(d, G, I, &w); 
+
+    if (res != 0 || dag_reach_index_build(d) != 0) {
+        fprintf(stderr, "ERROR: test_reach_index - could not build index\n");
+    }
+    if (!dag_reach_index_is_valid(d) || dag_reach_index_memory(d) == 0) {
+        fprintf(stderr, "ERROR: test_reach_index - index not valid\n");
+    }
+
+    struct Vertex *all[] = {A, B, C, D, F, G, I};
+    for (int i = 0; i < 7; i++) {
+        for (int j = 0; j < 7; j++) {
+            int expected = dag_reachable(d, all[i], all[j], SEARCH_FORWARD);
+            if (dag_is_connected(d, all[i], all[j]) != expected) {
+                fprintf(stderr, "ERROR: test_reach_index - wrong answer\n");
+            }
+        }
+    }
+
+    // Adding an edge invalidates the index
+    dag_add_edge(d, C, I, &w);
+    if (dag_reach_index_is_valid(d)) {
+        fprintf(stderr, "ERROR: test_reach_index - index still valid\n");
+    }
+    if (dag_is_connected(d, A, I) != 1 || dag_is_connected(d, C, I) != 1) {
+        fprintf(stderr, "ERROR: test_reach_index - stale answer\n");
+    }
+
+    dag_reach_index_destroy(d);
+    if (dag_reach_index_memory(d) != 0) {
+        fprintf(stderr, "ERROR: test_reach_index - index not destroyed\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_duplicate_edges(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w1 = 1, w2 = 2;
+    struct Vertex *v[40];
+    for (int i = 0; i < 40; i++) {
+        v[i] = dag_add_vertex(d, &w1);
+    }
+
+    // Enough edges to make the edge index grow a few times
+    int res = 0;
+    for (int i = 0; i < 39; i++) {
+        res -= dag_add_edge(d, v[i], v[i + 1], &w1);
+        if (i + 2 < 40) {
+            res -= dag_add_edge(d, v[i], v[i + 2], &w1);
+        }
+    }
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - Could not add edge\n");
+    }
+
+    for (int i = 0; i < 39; i++) {
+        struct Edge *e = dag_find_edge(d, v[i], v[i + 1]);
+        if (e == NULL || dag_e_get_from(e) != v[i] || dag_e_get_to(e) != v[i + 1]) {
+            fprintf(stderr, "ERROR: test_duplicate_edges - edge not found\n");
+        }
+        if (i + 3 < 40 && dag_find_edge(d, v[i], v[i + 3]) != NULL) {
+            fprintf(stderr, "ERROR: test_duplicate_edges - found missing edge\n");
+        }
+    }
+
+    // Parallel edges are allowed by default
+    struct Edge *first = dag_find_edge(d, v[0], v[1]);
+    if (dag_add_edge(d, v[0], v[1], &w2) != 0 || dag_v_get_out_degree(v[0]) != 3) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - duplicate not added\n");
+    }
+    if (dag_find_edge(d, v[0], v[1]) != first) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - wrong parallel edge\n");
+    }
+
+    dag_set_duplicate_edges(d, DUPLICATES_REJECT);
+    if (dag_add_edge(d, v[1], v[2], &w2) != -1 || dag_v_get_out_degree(v[1]) != 2) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - duplicate not rejected\n");
+    }
+
+    dag_set_duplicate_edges(d, DUPLICATES_MERGE);
+    if (dag_add_edge(d, v[1], v[2], &w2) != 0 || dag_v_get_out_degree(v[1]) != 2) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - duplicate not merged\n");
+    }
+    if (dag_e_get_weight(dag_find_edge(d, v[1], v[2])) != &w1) {
+        fprintf(stderr, "ERROR: test_duplicate_edges - merged weight changed\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_arena_alloc(void) {
+    struct Dag *d = dag_create_with_alloc(add_ints, int_compare, ALLOC_ARENA);
+
+    // A chain of 1000 vertices where every vertex also has an edge to the
+    // vertex ten steps ahead, so adjacency arrays grow in the arena.
+    int w = 1;
+    struct Vertex *v[1000];
+    for (int i = 0; i < 1000; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+
+    int res = 0;
+    for (int i = 0; i < 999; i++) {
+        res -= dag_add_edge(d, v[i], v[i + 1], &w);
+        if (i + 10 < 1000) {
+            res -= dag_add_edge(d, v[i], v[i + 10], &w);
+        }
+        for (int j = 1; j < 8 && i + j * 10 < 1000; j++) {
+            res -= dag_add_edge(d, v[0], v[i + j * 10], &w);
+        }
+    }
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_arena_alloc - Could not add edge\n");
+    }
+
+    if (dag_is_connected(d, v[0], v[999]) != 1 
+            || dag_is_connected(d, v[999], v[0]) != 0) {
+        fprintf(stderr, "ERROR: test_arena_alloc - wrong connectivity\n");
+    }
+    if (dag_find_edge(d, v[5], v[15]) == NULL) {
+        fprintf(stderr, "ERROR: test_arena_alloc - edge not found\n");
+    }
+
+    // Every vertex and edge on the chain weighs 1.
+    int *weight = dag_weight_of_longest_path(d, v[0], v[999], get_int, get_int);
+    if (weight == NULL || *weight != 1999) {
+        fprintf(stderr, "ERROR: test_arena_alloc - wrong longest path\n");
+    }
+
+    free(weight);
+    dag_destroy(d, false);
+}
+
+void test_queue(void) {
+    struct Queue *q = queue_create();
+    int values[100];
+
+    // Interleave enqueues and dequeues so the buffer wraps around and grows
+    // while it holds elements.
+    int next_in = 0, next_out = 0;
+    for (int round = 0; round < 10; round++) {
+        for (int i = 0; i < 10; i++) {
+            values[next_in] = next_in;
+            queue_enqueue(q, &values[next_in++]);
+        }
+        for (int i = 0; i < 5; i++) {
+            int *v = queue_dequeue(q);
+            if (v == NULL || *v != next_out++) {
+                fprintf(stderr, "ERROR: test_queue - wrong element\n");
+            }
+        }
+    }
+    while (!queue_is_empty(q)) {
+        int *v = queue_dequeue(q);
+        if (*v != next_out++) {
+            fprintf(stderr, "ERROR: test_queue - wrong element\n");
+        }
+    }
+    if (next_out != 100 || queue_dequeue(q) != NULL) {
+        fprintf(stderr, "ERROR: test_queue - wrong size\n");
+    }
+
+    queue_enqueue(q, &values[0]);
+    queue_reset(q);
+    if (!queue_is_empty(q) || queue_peek(q) != NULL) {
+        fprintf(stderr, "ERROR: test_queue - reset failed\n");
+    }
+
+    queue_destroy(q);
+}
+
+// Same graph as test_longest_path_large
+void test_typed_dag(void) {
+    struct dag_i64 *g = dag_i64_create();
+
+    int64_t vw[] = {1, 2, 2, 6, 5, 15, 20, 25};
+    for (int i = 0; i < 8; i++) {
+        if (dag_i64_add_vertex(g, vw[i]) != i) {
+            fprintf(stderr, "ERROR: test_typed_dag - wrong vertex id\n");
+        }
+    }
+
+    int from[] = {0, 0, 1, 1, 1, 2, 2, 3, 4, 4};
+    int to[] = {1, 3, 2, 3, 4, 4, 7, 4, 5, 6};
+    int64_t ew[] = {1, 2, 2, 5, 6, 3, 2, 7, 8, 4};
+    int res = 0;
+    for (int i = 0; i < 10; i++) {
+        res -= dag_i64_add_edge(g, from[i], to[i], ew[i]);
+    }
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_typed_dag - Could not add edge\n");
+    }
+    if (dag_i64_add_edge(g, 6, 0, 1) != -1) {
+        fprintf(stderr, "ERROR: test_typed_dag - Graph allows cycles!\n");
+    }
+    if (dag_i64_find_edge(g, 3, 4) != 7 || dag_i64_e_get_weight(g, 7) != 7) {
+        fprintf(stderr, "ERROR: test_typed_dag - wrong edge\n");
+    }
+
+    int64_t weight;
+    int path[8];
+    int len;
+    int expected[] = {0, 1, 3, 4, 6};
+    if (dag_i64_longest_path(g, 0, 6, &weight, path, &len) != 0 
+            || weight != 51 || len != 5) {
+        fprintf(stderr, "ERROR: test_typed_dag - wrong longest path\n");
+    }
+    for (int i = 0; i < len && i < 5; i++) {
+        if (path[i] != expected[i]) {
+            fprintf(stderr, "ERROR: test_typed_dag - wrong path\n");
+        }
+    }
+    if (dag_i64_longest_path(g, 3, 7, &weight, NULL, NULL) != -1) {
+        fprintf(stderr, "ERROR: test_typed_dag - found missing path\n");
+    }
+
+    // Ids outside 0 to 7 are rejected rather than written past the arrays.
+    if (dag_i64_add_edge(g, 0, 8, 1) != -1 
+            || dag_i64_add_edge(g, -1, 0, 1) != -1
+            || dag_i64_is_connected(g, 0, 8) != -1 
+            || dag_i64_is_connected(g, -1, -1) != -1
+            || dag_i64_find_edge(g, 8, 0) != -1
+            || dag_i64_longest_path(g, 8, 0, &weight, NULL, NULL) != -1
+            || dag_i64_longest_path(g, 0, -1, &weight, NULL, NULL) != -1) {
+        fprintf(stderr, "ERROR: test_typed_dag - bad id accepted\n");
+    }
+
+    dag_i64_destroy(g);
+}
+
+struct path_count {
+    int paths;
+    int vertices;
+    int stop_after;
+};
+
+static int count_path(struct Vertex **path, int len, void *ctx) {
+    struct path_count *c = ctx;
+    (void) path;
+    c->paths++;
+    c->vertices += len;
+    return c->paths == c->stop_after;
+}
+
+void test_foreach_path(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    // A lattice of 10 diamonds has 2^10 paths from top to bottom.
+    int w = 1;
+    struct Vertex *top = dag_add_vertex(d, &w);
+    struct Vertex *prev = top;
+    int res = 0;
+    for (int i = 0; i < 10; i++) {
+        struct Vertex *l = dag_add_vertex(d, &w);
+        struct Vertex *r = dag_add_vertex(d, &w);
+        struct Vertex *next = dag_add_vertex(d, &w);
+        res -= dag_add_edge(d, prev, l, &w);
+        res -= dag_add_edge(d, prev, r, &w);
+        res -= dag_add_edge(d, l, next, &w);
+        res -= dag_add_edge(d, r, next, &w);
+        prev = next;
+    }
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_foreach_path - Could not add edge\n");
+    }
+
+    struct path_count c = {0, 0, -1};
+    if (dag_foreach_path(d, top, prev, count_path, &c) != 0 
+            || c.paths != 1024 || c.vertices != 1024 * 21) {
+        fprintf(stderr, "ERROR: test_foreach_path - wrong paths %d\n", c.paths);
+    }
+
+    struct path_count stop = {0, 0, 3};
+    if (dag_foreach_path(d, top, prev, count_path, &stop) != 1 || stop.paths != 3) {
+        fprintf(stderr, "ERROR: test_foreach_path - did not stop\n");
+    }
+
+    struct path_count none = {0, 0, -1};
+    if (dag_foreach_path(d, prev, top, count_path, &none) != 0 || none.paths != 0) {
+        fprintf(stderr, "ERROR: test_foreach_path - found missing path\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_count_paths(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    // A lattice of 64 diamonds has 2^64 paths from top to bottom.
+    int w = 1;
+    struct Vertex *top = dag_add_vertex(d, &w);
+    struct Vertex *prev = top;
+    struct Vertex *tenth = NULL;
+    int res = 0;
+    for (int i = 0; i < 64; i++) {
+        struct Vertex *l = dag_add_vertex(d, &w);
+        struct Vertex *r = dag_add_vertex(d, &w);
+        struct Vertex *next = dag_add_vertex(d, &w);
+        res -= dag_add_edge(d, prev, l, &w);
+        res -= dag_add_edge(d, prev, r, &w);
+        res -= dag_add_edge(d, l, next, &w);
+        res -= dag_add_edge(d, r, next, &w);
+        prev = next;
+        if (i == 9) tenth = next;
+    }
+    if (res != 0) {
+        fprintf(stderr, "ERROR: test_count_paths - Could not add edge\n");
+    }
+
+    if (dag_count_paths(d, top, tenth) != 1024) {
+        fprintf(stderr, "ERROR: test_count_paths - wrong count\n");
+    }
+    if (dag_count_paths(d, top, prev) != UINT64_MAX) {
+        fprintf(stderr, "ERROR: test_count_paths - count did not saturate\n");
+    }
+    if (dag_count_paths(d, prev, top) != 0) {
+        fprintf(stderr, "ERROR: test_count_paths - found missing path\n");
+    }
+
+    uint64_t *counts = malloc(dag_get_vertex_count(d) * sizeof(*counts));
+    if (dag_count_paths_from(d, tenth, counts) != 0 
+            || counts[dag_v_get_id(tenth)] != 1 
+            || counts[dag_v_get_id(top)] != 0
+            || counts[dag_v_get_id(tenth) + 3] != 2) {
+        fprintf(stderr, "ERROR: test_count_paths - wrong single source counts\n");
+    }
+    free(counts);
+
+    char *big = dag_count_paths_big(d, top, prev);
+    if (big == NULL || strcmp(big, "18446744073709551616") != 0) {
+        fprintf(stderr, "ERROR: test_count_paths - wrong big count\n");
+    }
+    free(big);
+
+    big = dag_count_paths_big(d, prev, top);
+    if (big == NULL || strcmp(big, "0") != 0) {
+        fprintf(stderr, "ERROR: test_count_paths - wrong big count\n");
+    }
+    free(big);
+
+    dag_destroy(d, false);
+}
+
+void test_add_edges_bulk(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w = 1;
+    struct Vertex *v[6];
+    for (int i = 0; i < 6; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    dag_add_edge(d, v[0], v[1], &w);
+
+    // Edges against the initial vertex order, forming the chain 
+    // 5 -> 4 -> 3 -> 2 -> 0 -> 1
+    struct Vertex *from[] = {v[5], v[4], v[3], v[2]};
+    struct Vertex *to[] = {v[4], v[3], v[2], v[0]};
+    void *weights[] = {&w, &w, &w, &w};
+    int cyclic[4];
+    int n_cyclic = -1;
+
+    if (dag_add_edges_bulk(d, from, to, weights, 4, cyclic, &n_cyclic) != 0 
+            || n_cyclic != 0) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - Could not add edges\n");
+    }
+    if (dag_is_connected(d, v[5], v[1]) != 1 || dag_find_edge(d, v[2], v[0]) == NULL) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - edges missing\n");
+    }
+    for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < dag_v_get_out_degree(v[i]); j++) {
+            struct Vertex *s = dag_v_get_successor(v[i], j);
+            if (dag_v_get_topo_rank(v[i]) >= dag_v_get_topo_rank(s)) {
+                fprintf(stderr, "ERROR: test_add_edges_bulk - invalid order\n");
+            }
+        }
+    }
+
+    // 1 -> 3 closes the cycle 3 -> 2 -> 0 -> 1 -> 3, while 5 -> 0 does not
+    // take part in any cycle.
+    struct Vertex *bad_from[] = {v[5], v[1]};
+    struct Vertex *bad_to[] = {v[0], v[3]};
+    if (dag_add_edges_bulk(d, bad_from, bad_to, NULL, 2, cyclic, &n_cyclic) != -1
+            || n_cyclic != 1 || cyclic[0] != 1) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - cycle not reported\n");
+    }
+    if (dag_find_edge(d, v[5], v[0]) != NULL || dag_v_get_out_degree(v[5]) != 1) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - not rolled back\n");
+    }
+
+    dag_set_duplicate_edges(d, DUPLICATES_REJECT);
+    struct Vertex *dup_from[] = {v[5], v[5]};
+    struct Vertex *dup_to[] = {v[0], v[0]};
+    if (dag_add_edges_bulk(d, dup_from, dup_to, NULL, 2, NULL, NULL) != -1
+            || dag_find_edge(d, v[5], v[0]) != NULL) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - duplicate not rejected\n");
+    }
+
+    dag_set_duplicate_edges(d, DUPLICATES_MERGE);
+    if (dag_add_edges_bulk(d, dup_from, dup_to, NULL, 2, NULL, NULL) != 0
+            || dag_v_get_out_degree(v[5]) != 2) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - duplicate not merged\n");
+    }
+
+    dag_destroy(d, false);
+
+    // Only edges on a cycle are reported, not 1 -> 2 between the cycles
+    // 0 -> 1 -> 0 and 2 -> 3 -> 2, nor 3 -> 4 after them. 4 -> 4 is a 
+    // cycle of its own.
+    d = dag_create(NULL, NULL);
+    for (int i = 0; i < 5; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    struct Vertex *cyc_from[] = {v[0], v[1], v[1], v[2], v[3], v[3], v[4]};
+    struct Vertex *cyc_to[] = {v[1], v[0], v[2], v[3], v[2], v[4], v[4]};
+    int cyc[7];
+    if (dag_add_edges_bulk(d, cyc_from, cyc_to, NULL, 7, cyc, &n_cyclic) != -1
+            || n_cyclic != 5 || cyc[0] != 0 || cyc[1] != 1 || cyc[2] != 3
+            || cyc[3] != 4 || cyc[4] != 6) {
+        fprintf(stderr, "ERROR: test_add_edges_bulk - wrong cycle edges\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_topological_levels(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    // A layered graph of 20 layers with 50 vertices each, where every vertex
+    // has an edge from a vertex in the layer just above.
+    int w = 1;
+    int n = 1000;
+    struct Vertex *v[1000];
+    for (int i = 0; i < n; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    for (int i = 50; i < n; i++) {
+        dag_add_edge(d, v[i - 50 + (i * 7) % 50 - (i % 50)], v[i], &w);
+        if (i >= 100) {
+            dag_add_edge(d, v[(i * 13) % (i - i % 50 - 50)], v[i], &w);
+        }
+    }
+
+    for (int threads = 1; threads <= 4; threads += 3) {
+        struct TopoLevels *levels = dag_topological_levels(d, threads);
+        if (levels == NULL || levels->n_levels != 20 || levels->n_ids != n) {
+            fprintf(stderr, "ERROR: test_topological_levels - wrong levels\n");
+            dag_topological_levels_destroy(levels);
+            continue;
+        }
+
+        int level_of[1000];
+        for (int l = 0; l < levels->n_levels; l++) {
+            for (int i = levels->level_start[l]; i < levels->level_start[l + 1]; i++) {
+                level_of[levels->ids[i]] = l;
+            }
+        }
+        for (int i = 0; i < n; i++) {
+            if (level_of[i] != i / 50) {
+                fprintf(stderr, "ERROR: test_topological_levels - wrong level\n");
+                break;
+            }
+        }
+
+        dag_topological_levels_destroy(levels);
+    }
+
+    dag_destroy(d, false);
+}
+
+// Context of check_task, recording which tasks have finished.
+struct exec_check {
+    atomic_int done[1000];
+    atomic_int runs;
+    atomic_int early;
+    int stop_at;
+};
+
+static int check_task(struct Vertex *v, void *ctx) {
+    struct exec_check *c = ctx;
+
+    for (int i = 0; i < dag_v_get_in_degree(v); i++) {
+        int p = dag_v_get_id(dag_v_get_predecessor(v, i));
+        if (!atomic_load(&c->done[p])) {
+            atomic_fetch_add(&c->early, 1);
+        }
+    }
+    atomic_fetch_add(&c->runs, 1);
+    atomic_store(&c->done[dag_v_get_id(v)], 1);
+
+    return dag_v_get_id(v) == c->stop_at;
+}
+
+void test_execute(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    // Layers of 50 vertices, each with edges from two earlier vertices.
+    int w = 1;
+    int n = 1000;
+    struct Vertex *v[1000];
+    for (int i = 0; i < n; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    for (int i = 50; i < n; i++) {
+        dag_add_edge(d, v[(i * 7) % (i - i % 50)], v[i], &w);
+        dag_add_edge(d, v[i - 50], v[i], &w);
+    }
+
+    static struct exec_check c;
+    static double task_seconds[1000];
+    double total = -1;
+    for (int threads = 1; threads <= 4; threads += 3) {
+        memset(&c, 0, sizeof(c));
+        c.stop_at = -1;
+        if (dag_execute(d, check_task, &c, threads, task_seconds, &total) != 0
+                || atomic_load(&c.runs) != n || total < 0) {
+            fprintf(stderr, "ERROR: test_execute - not all tasks run\n");
+        }
+        if (atomic_load(&c.early) != 0) {
+            fprintf(stderr, "ERROR: test_execute - task run before predecessor\n");
+        }
+    }
+
+    // Vertex 100 is in the third layer, so 150 and its descendants never run.
+    memset(&c, 0, sizeof(c));
+    c.stop_at = 100;
+    if (dag_execute(d, check_task, &c, 4, NULL, NULL) != 1 
+            || atomic_load(&c.done[150]) || atomic_load(&c.runs) == n) {
+        fprintf(stderr, "ERROR: test_execute - not stopped\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+void test_topological_order_cache(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int w = 1;
+    struct Vertex *v[5];
+    for (int i = 0; i < 4; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    dag_add_edge(d, v[2], v[1], &w);
+    dag_add_edge(d, v[1], v[0], &w);
+    dag_add_edge(d, v[3], v[0], &w);
+
+    int n;
+    struct Vertex **first = dag_topological_order(d, &n);
+    struct list *l = dag_topological_ordering(d);
+    if (first == NULL || n != 4 || dag_topological_order(d, NULL) != first) {
+        fprintf(stderr, "ERROR: test_topological_order_cache - not cached\n");
+    }
+
+    // The list is a copy of the cached order.
+    int i = 0;
+    for (struct node *it = list_first(l); it != NULL; it = list_next(it)) {
+        if (i >= n || it->value != first[i++]) {
+            fprintf(stderr, "ERROR: test_topological_order_cache - list differs\n");
+            break;
+        }
+    }
+    dag_destroy_path(l);
+
+    // Modifications invalidate the cache, and the graph must be intact for
+    // the order to be recomputed.
+    v[4] = dag_add_vertex(d, &w);
+    dag_add_edge(d, v[0], v[4], &w);
+    struct Vertex **order = dag_topological_order(d, &n);
+    int pos[5] = {-1, -1, -1, -1, -1};
+    for (i = 0; order && i < n; i++) {
+        pos[dag_v_get_id(order[i])] = i;
+    }
+    if (order == NULL || n != 5 || pos[2] > pos[1] || pos[1] > pos[0] 
+            || pos[3] > pos[0] || pos[0] > pos[4] || pos[2] < 0 || pos[3] < 0) {
+        fprintf(stderr, "ERROR: test_topological_order_cache - invalid order\n");
+    }
+
+    dag_destroy(d, false);
+}
+
+// Same graph as test_longest_path_large
+void test_paths_from(void) {
+    struct Dag *d = dag_create(add_ints, int_compare);
+
+    int vw[] = {1, 2, 2, 6, 5, 15, 20, 25};
+    struct Vertex *v[8];
+    for (int i = 0; i < 8; i++) {
+        v[i] = dag_add_vertex(d, &vw[i]);
+    }
+
+    int from[] = {0, 0, 1, 1, 1, 2, 2, 3, 4, 4};
+    int to[] = {1, 3, 2, 3, 4, 4, 7, 4, 5, 6};
+    int ew[] = {1, 2, 2, 5, 6, 3, 2, 7, 8, 4};
+    for (int i = 0; i < 10; i++) {
+        dag_add_edge(d, v[from[i]], v[to[i]], &ew[i]);
+    }
+
+    void *dist[8];
+    struct Edge *pred[8];
+
+    // Longest a -> g is a -> b -> d -> e -> g, shortest a -> b -> e -> g.
+    if (dag_longest_paths_from(d, v[0], get_int, get_int, dist, pred) != 0
+            || dist[6] == NULL || *(int *) dist[6] != 51 
+            || dag_e_get_from(pred[3]) != v[1] || pred[0] != NULL) {
+        fprintf(stderr, "ERROR: test_paths_from - wrong longest paths\n");
+    }
+    for (int i = 0; i < 8; i++) {
+        free(dist[i]);
+    }
+
+    if (dag_shortest_paths_from(d, v[0], get_int, get_int, dist, pred) != 0
+            || dist[6] == NULL || *(int *) dist[6] != 39 
+            || dag_e_get_from(pred[6]) != v[4] 
+            || dag_e_get_from(pred[4]) != v[1]) {
+        fprintf(stderr, "ERROR: test_paths_from - wrong shortest paths\n");
+    }
+    for (int i = 0; i < 8; i++) {
+        free(dist[i]);
+    }
+
+    // From c and d, e is closest to c and a can not be reached.
+    struct Vertex *sources[] = {v[3], v[2]};
+    if (dag_shortest_paths_from_sources(d, sources, 2, get_int, get_int, 
+                                        dist, pred) != 0
+            || dist[0] != NULL || dist[4] == NULL || *(int *) dist[4] != 10
+            || dag_e_get_from(pred[4]) != v[2] || *(int *) dist[7] != 29) {
+        fprintf(stderr, "ERROR: test_paths_from - wrong multi-source paths\n");
+    }
+    for (int i = 0; i < 8; i++) {
+        free(dist[i]);
+    }
+
+    if (dag_longest_paths_from_sources(d, sources, 2, get_int, get_int, 
+                                       dist, NULL) != 0
+            || *(int *) dist[4] != 18 || *(int *) dist[3] != 6) {
+        fprintf(stderr, "ERROR: test_paths_from - wrong multi-source paths\n");
+    }
+    for (int i = 0; i < 8; i++) {
+        free(dist[i]);
+    }
+
+    dag_destroy(d, false);
+}
+
+static const void *string_bytes(void *w, size_t *size) {
+    *size = strlen(w) + 1;
+    return w;
+}
+
+void test_snapshot(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+
+    int vw[] = {10, 11, 12, 13, 14};
+    char *ew[] = {"a", "bc", "def", "", "ghij", "k"};
+    struct Vertex *v[5];
+    for (int i = 0; i < 5; i++) {
+        v[i] = dag_add_vertex(d, &vw[i]);
+    }
+    int from[] = {3, 0, 0, 1, 3, 2};
+    int to[] = {1, 1, 2, 4, 4, 4};
+    for (int i = 0; i < 6; i++) {
+        dag_add_edge(d, v[from[i]], v[to[i]], ew[i]);
+    }
+
+    char path[] = "/tmp/dag_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: test_snapshot - Could not create file\n");
+        dag_destroy(d, false);
+        return;
+    }
+    close(fd);
+
+    struct DagSnapshot *s = NULL;
+    FILE *f;
+    if (dag_save(d, path, sizeof(int), 0, NULL, string_bytes) != 0
+            || (s = dag_open_mmap(path)) == NULL) {
+        fprintf(stderr, "ERROR: test_snapshot - Could not save and map\n");
+        unlink(path);
+        dag_destroy(d, false);
+        return;
+    }
+
+    if (dag_snapshot_vertex_count(s) != 5 || dag_snapshot_edge_count(s) != 6
+            || dag_snapshot_verify(s) != 0) {
+        fprintf(stderr, "ERROR: test_snapshot - wrong counts\n");
+    }
+    for (int i = 0; i < 5; i++) {
+        int n, first;
+        const int32_t *succ = dag_snapshot_successors(s, i, &n, &first);
+        const int *w = dag_snapshot_v_get_weight(s, i, NULL);
+        if (n != dag_v_get_out_degree(v[i]) || *w != vw[i]) {
+            fprintf(stderr, "ERROR: test_snapshot - wrong vertex\n");
+            continue;
+        }
+        for (int j = 0; j < n; j++) {
+            struct Edge *e = dag_v_get_out_edge(v[i], j);
+            size_t len;
+            const char *ws = dag_snapshot_e_get_weight(s, first + j, &len);
+            if (succ[j] != dag_v_get_id(dag_e_get_to(e))
+                    || dag_snapshot_e_get_to(s, first + j) != succ[j]
+                    || len != strlen(dag_e_get_weight(e)) + 1
+                    || strcmp(ws, dag_e_get_weight(e)) != 0) {
+                fprintf(stderr, "ERROR: test_snapshot - wrong edge\n");
+            }
+        }
+    }
+
+    // Vertex 4 has predecessors 1, 3 and 2, reached by their edges.
+    int n;
+    const int32_t *edges;
+    const int32_t *pred = dag_snapshot_predecessors(s, 4, &n, &edges);
+    if (n != 3) {
+        fprintf(stderr, "ERROR: test_snapshot - wrong predecessors\n");
+    }
+    for (int j = 0; j < n; j++) {
+        int first, count;
+        dag_snapshot_successors(s, pred[j], &count, &first);
+        if (edges[j] < first || edges[j] >= first + count 
+                || dag_snapshot_e_get_to(s, edges[j]) != 4) {
+            fprintf(stderr, "ERROR: test_snapshot - wrong predecessor edge\n");
+        }
+    }
+
+    const int32_t *order = dag_snapshot_topological_order(s, &n);
+    int pos[5];
+    for (int i = 0; i < n; i++) {
+        pos[order[i]] = i;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (pos[from[i]] >= pos[to[i]]) {
+            fprintf(stderr, "ERROR: test_snapshot - wrong order\n");
+        }
+    }
+    dag_snapshot_close(s);
+
+    // A truncated file is rejected, also when the size in the header is 
+    // changed to match, which is the last word equal to the old size.
+    f = fopen(path, "rb");
+    char buf[4096];
+    size_t size = fread(buf, 1, sizeof(buf), f);
+    fclose(f);
+    size_t cut = size - 16;
+    size_t size_pos = 0;
+    for (size_t i = 8; i + 8 <= 256; i += 8) {
+        uint64_t word;
+        memcpy(&word, &buf[i], sizeof(word));
+        if (word == size) size_pos = i;
+    }
+    uint64_t cut_size = cut;
+    memcpy(&buf[size_pos], &cut_size, sizeof(cut_size));
+    f = fopen(path, "wb");
+    fwrite(buf, 1, cut, f);
+    fclose(f);
+    if (size_pos == 0 || (s = dag_open_mmap(path)) != NULL) {
+        fprintf(stderr, "ERROR: test_snapshot - mapped truncated file\n");
+        dag_snapshot_close(s);
+    }
+    if (truncate(path, cut - 8) != 0 || dag_open_mmap(path) != NULL) {
+        fprintf(stderr, "ERROR: test_snapshot - mapped truncated file\n");
+    }
+
+    // Anything else is rejected.
+    f = fopen(path, "w");
+    fprintf(f, "not a snapshot, but long enough to hold a header......"
+               "...............................................\n");
+    fclose(f);
+    if (dag_open_mmap(path) != NULL) {
+        fprintf(stderr, "ERROR: test_snapshot - mapped invalid file\n");
+    }
+
+    unlink(path);
+    dag_destroy(d, false);
+}
+
+// Writes text to a new temporary file, whose name is stored in path.
+static int write_temp(char *path, const char *text) {
+    strcpy(path, "/tmp/dag_test_XXXXXX");
+    int fd = mkstemp(path);
+    if (fd < 0) return -1;
+
+    size_t len = strlen(text);
+    int res = write(fd, text, len) == (ssize_t) len ? 0 : -1;
+    close(fd);
+    return res;
+}
+
+void test_load_edge_list(void) {
+    char path[32];
+    struct Dag *d = dag_create(NULL, NULL);
+    struct EdgeList *keys;
+    struct LoadResult r;
+
+    if (write_temp(path, "# from\tto\tweight\n"
+                         "a\tb\t5\n"
+                         "b\tcc\t-7\r\n"
+                         "\n"
+                         "a\tcc\n"
+                         "cc\td\t12") != 0) {
+        fprintf(stderr, "ERROR: test_load_edge_list - Could not write file\n");
+        dag_destroy(d, false);
+        return;
+    }
+    if (dag_load_edge_list(d, path, '\t', KEYS_STRING, &keys, &r) != 0
+            || r.edges != 4 || r.vertices != 4 || r.lines != 6) {
+        fprintf(stderr, "ERROR: test_load_edge_list - Could not load\n");
+    }
+    struct Vertex *a = dag_edge_list_vertex(keys, "a");
+    struct Vertex *b = dag_edge_list_vertex(keys, "b");
+    struct Vertex *c = dag_edge_list_vertex(keys, "cc");
+    struct Edge *e = dag_find_edge(d, b, c);
+    if (!a || !b || !c || dag_edge_list_vertex(keys, "c") != NULL
+            || strcmp(dag_v_get_weight(c), "cc") != 0 || e == NULL
+            || *(int64_t *) dag_e_get_weight(e) != -7
+            || dag_e_get_weight(dag_find_edge(d, a, c)) != NULL) {
+        fprintf(stderr, "ERROR: test_load_edge_list - wrong graph\n");
+    }
+    unlink(path);
+    dag_destroy(d, false);
+    dag_edge_list_destroy(keys);
+
+    // Line 4 closes the cycle 1 -> 2 -> 3 -> 1, and line 5 another one.
+    d = dag_create(NULL, NULL);
+    write_temp(path, "1,2\n2,3\n3,4\n3,01\n4,2\n");
+    if (dag_load_edge_list(d, path, ',', KEYS_INTEGER, &keys, &r) != -1
+            || r.cycle_line != 4 || r.edges != 0 || r.vertices != 4
+            || dag_v_get_out_degree(dag_edge_list_vertex(keys, "1")) != 0) {
+        fprintf(stderr, "ERROR: test_load_edge_list - cycle not reported\n");
+    }
+    unlink(path);
+    dag_destroy(d, false);
+    dag_edge_list_destroy(keys);
+
+    d = dag_create(NULL, NULL);
+    write_temp(path, "1,2,3\n2,3,x\n");
+    if (dag_load_edge_list(d, path, ',', KEYS_INTEGER, &keys, &r) != -1
+            || r.error_line != 2 || r.cycle_line != 0) {
+        fprintf(stderr, "ERROR: test_load_edge_list - bad line not reported\n");
+    }
+    unlink(path);
+    dag_destroy(d, false);
+    dag_edge_list_destroy(keys);
+}
+
+void test_stats(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+    struct DagStats stats;
+
+    int w = 1;
+    struct Vertex *v[4];
+    for (int i = 0; i < 4; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    dag_add_edge(d, v[0], v[1], &w);
+    dag_add_edge(d, v[1], v[2], &w);
+    dag_add_edge(d, v[2], v[3], &w);
+
+#ifdef DAG_STATS
+    dag_stats_reset(d);
+    dag_reachable(d, v[0], v[3], SEARCH_FORWARD);
+    if (dag_stats_get(d, &stats) != 0 
+            || stats.calls[DAG_API_REACHABLE] != 1
+            || stats.calls[DAG_API_ADD_EDGE] != 0
+            || stats.vertices_visited != 3 || stats.edges_scanned != 3
+            || stats.enqueues != 2 || stats.bytes_live == 0) {
+        fprintf(stderr, "ERROR: test_stats - wrong counters\n");
+    }
+
+    // Adjacency arrays grow, so live bytes do too.
+    uint64_t bytes = stats.bytes_live;
+    for (int i = 0; i < 8; i++) {
+        dag_add_edge(d, v[0], v[3], &w);
+    }
+    dag_stats_get(d, &stats);
+    if (stats.calls[DAG_API_ADD_EDGE] != 8 || stats.allocations < 8
+            || stats.bytes_live <= bytes) {
+        fprintf(stderr, "ERROR: test_stats - allocations not counted\n");
+    }
+#else
+    if (dag_stats_get(d, &stats) != -1 || stats.calls[DAG_API_ADD_EDGE] != 0) {
+        fprintf(stderr, "ERROR: test_stats - stats without DAG_STATS\n");
+    }
+#endif
+
+    dag_destroy(d, false);
+}
+
+#define SHARED_CHAIN 300
+#define SHARED_READERS 4
+
+struct SharedReaderCtx {
+    struct DagShared *s;
+    atomic_bool *done;
+    atomic_int *errors;
+};
+
+/**
+ * Checks every view it reads against the chain built by test_shared(): a view
+ * with m edges connects vertex 0 to vertex m, but not to vertex m + 1.
+ */
+static void *shared_reader(void *arg) {
+    struct SharedReaderCtx *ctx = arg;
+    struct DagReader *r = dag_reader_register(ctx->s);
+    if (r == NULL) {
+        atomic_fetch_add(ctx->errors, 1);
+        return NULL;
+    }
+
+    while (!atomic_load(ctx->done)) {
+        const struct DagView *view = dag_read_begin(r);
+        int m = dag_view_edge_count(view);
+        int n;
+        const int32_t *order = dag_view_topological_order(view, &n);
+        if (n != SHARED_CHAIN || dag_view_is_connected(r, 0, m) != 1
+                || (m + 1 < n && dag_view_is_connected(r, 0, m + 1) != 0)
+                || order[0] != 0) {
+            atomic_fetch_add(ctx->errors, 1);
+        }
+        dag_read_end(r);
+    }
+    dag_reader_unregister(r);
+
+    return NULL;
+}
+
+void test_shared(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+    int w = 1;
+    struct Vertex *v[SHARED_CHAIN];
+    for (int i = 0; i < SHARED_CHAIN; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+
+    struct DagShared *s = dag_shared_create(d, SHARED_READERS);
+    struct DagReader *r = dag_reader_register(s);
+
+    // A read section keeps its view while changes are published.
+    const struct DagView *view = dag_read_begin(r);
+    dag_add_edge(dag_shared_write_begin(s), v[0], v[1], &w);
+    dag_shared_write_end(s);
+    if (dag_view_edge_count(view) != 0 || dag_view_is_connected(r, 0, 1) != 0) {
+        fprintf(stderr, "ERROR: test_shared - view changed while read\n");
+    }
+    dag_read_end(r);
+
+    view = dag_read_begin(r);
+    if (dag_view_edge_count(view) != 1 || dag_view_is_connected(r, 0, 1) != 1
+            || dag_view_version(view) != 
+               dag_view_version(dag_read_begin(r))) {
+        fprintf(stderr, "ERROR: test_shared - change not published\n");
+    }
+    dag_read_end(r);
+    dag_reader_unregister(r);
+
+    atomic_bool done;
+    atomic_int errors;
+    atomic_init(&done, false);
+    atomic_init(&errors, 0);
+    struct SharedReaderCtx ctx = {s, &done, &errors};
+    pthread_t threads[SHARED_READERS];
+    for (int i = 0; i < SHARED_READERS; i++) {
+        pthread_create(&threads[i], NULL, shared_reader, &ctx);
+    }
+
+    // Each batch adds one edge, extending the chain.
+    for (int i = 1; i + 1 < SHARED_CHAIN; i++) {
+        struct Dag *wd = dag_shared_write_begin(s);
+        dag_add_edge(wd, v[i], v[i + 1], &w);
+        if (dag_shared_write_end(s) != 0) {
+            atomic_fetch_add(&errors, 1);
+        }
+    }
+    atomic_store(&done, true);
+    for (int i = 0; i < SHARED_READERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    if (atomic_load(&errors) != 0) {
+        fprintf(stderr, "ERROR: test_shared - %d inconsistent reads\n",
+                atomic_load(&errors));
+    }
+
+    dag_shared_destroy(s);
+    dag_destroy(d, false);
+}
+
+#define BUILDER_THREADS 4
+#define BUILDER_CHAIN 5000
+
+struct BuilderCtx {
+    struct DagBuildHandle *h;
+    int *first;
+    int *last;
+};
+
+// Stages a chain of BUILDER_CHAIN vertices.
+static void *builder_thread(void *arg) {
+    static int w = 1;
+    struct BuilderCtx *ctx = arg;
+
+    int prev = dag_build_add_vertex(ctx->h, &w);
+    *ctx->first = prev;
+    for (int i = 1; i < BUILDER_CHAIN; i++) {
+        int id = dag_build_add_vertex(ctx->h, &w);
+        dag_build_add_edge(ctx->h, prev, id, &w);
+        prev = id;
+    }
+    *ctx->last = prev;
+
+    return NULL;
+}
+
+void test_builder(void) {
+    int w = 1;
+    int first[BUILDER_THREADS];
+    int last[BUILDER_THREADS];
+    struct BuilderCtx ctx[BUILDER_THREADS];
+    pthread_t threads[BUILDER_THREADS];
+
+    struct DagBuilder *b = dag_builder_create(NULL, NULL, ALLOC_MALLOC,
+                                              BUILDER_THREADS);
+    for (int t = 0; t < BUILDER_THREADS; t++) {
+        ctx[t] = (struct BuilderCtx) {dag_builder_handle(b, t), &first[t],
+                                      &last[t]};
+        pthread_create(&threads[t], NULL, builder_thread, &ctx[t]);
+    }
+    for (int t = 0; t < BUILDER_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    // Join the chains end to end, across handles.
+    for (int t = 0; t + 1 < BUILDER_THREADS; t++) {
+        dag_build_add_edge(dag_builder_handle(b, t), last[t], first[t + 1], 
+                           &w);
+    }
+
+    struct Dag *d = dag_builder_finish(b);
+    if (d == NULL || dag_get_vertex_count(d) != BUILDER_THREADS * BUILDER_CHAIN
+            || dag_is_connected(d, dag_builder_vertex(b, first[0]),
+                                dag_builder_vertex(b, last[BUILDER_THREADS - 1])) != 1
+            || dag_is_connected(d, dag_builder_vertex(b, last[1]),
+                                dag_builder_vertex(b, first[1])) != 0) {
+        fprintf(stderr, "ERROR: test_builder - wrong graph built\n");
+    }
+    if (d) dag_destroy(d, false);
+    dag_builder_destroy(b);
+
+    // A cycle across handles is found when merging.
+    b = dag_builder_create(NULL, NULL, ALLOC_ARENA, 2);
+    struct DagBuildHandle *h0 = dag_builder_handle(b, 0);
+    struct DagBuildHandle *h1 = dag_builder_handle(b, 1);
+    int x = dag_build_add_vertex(h0, &w);
+    int y = dag_build_add_vertex(h1, &w);
+    dag_build_add_edge(h0, x, y, &w);
+    dag_build_add_edge(h1, y, x, &w);
+    if (dag_builder_finish(b) != NULL || dag_builder_vertex(b, x) != NULL) {
+        fprintf(stderr, "ERROR: test_builder - cycle not rejected\n");
+    }
+    dag_builder_destroy(b);
+}
+
+#define REMOVE_N 64
+
+void test_remove(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+    int w = 1;
+    struct Vertex *v[REMOVE_N];
+    for (int i = 0; i < REMOVE_N; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+
+    // Parallel edges take over the hash slot of a removed one.
+    dag_add_edge(d, v[0], v[1], &w);
+    dag_add_edge(d, v[0], v[1], &w);
+    if (dag_remove_edge(d, v[0], v[1], false) != 0
+            || dag_find_edge(d, v[0], v[1]) == NULL
+            || dag_remove_edge(d, v[0], v[1], false) != 0
+            || dag_find_edge(d, v[0], v[1]) != NULL
+            || dag_remove_edge(d, v[0], v[1], false) != -1
+            || dag_v_get_out_degree(v[0]) != 0 
+            || dag_v_get_in_degree(v[1]) != 0) {
+        fprintf(stderr, "ERROR: test_remove - parallel edges\n");
+    }
+
+    // Add every third forward edge, remove some, and compare the lookups
+    // with what should be left.
+    bool present[REMOVE_N][REMOVE_N] = {{false}};
+    for (int i = 0; i < REMOVE_N; i++) {
+        for (int j = i + 1; j < REMOVE_N; j++) {
+            if ((i * REMOVE_N + j) % 3 == 0) {
+                dag_add_edge(d, v[i], v[j], &w);
+                present[i][j] = true;
+            }
+        }
+    }
+    for (int i = 0; i < REMOVE_N; i++) {
+        for (int j = i + 1; j < REMOVE_N; j++) {
+            if (present[i][j] && (i + j) % 2 == 0) {
+                dag_remove_edge(d, v[i], v[j], false);
+                present[i][j] = false;
+            }
+        }
+    }
+    int mismatches = 0;
+    for (int i = 0; i < REMOVE_N; i++) {
+        for (int j = 0; j < REMOVE_N; j++) {
+            struct Edge *e = dag_find_edge(d, v[i], v[j]);
+            mismatches += (e != NULL) != present[i][j];
+            mismatches += e && (dag_e_get_from(e) != v[i] 
+                                || dag_e_get_to(e) != v[j]);
+        }
+    }
+    if (mismatches != 0) {
+        fprintf(stderr, "ERROR: test_remove - %d wrong lookups\n", 
+                mismatches);
+    }
+
+    // Removing a vertex leaves a tombstone, which rejects further use.
+    int removed_id = dag_v_get_id(v[3]);
+    if (dag_remove_vertex(d, v[3], false) != 0
+            || dag_add_edge(d, v[0], v[3], &w) != -1
+            || dag_add_edges_bulk(d, &v[0], &v[3], NULL, 1, NULL, NULL) != -1
+            || dag_remove_vertex(d, v[3], false) != -1
+            || dag_get_vertex(d, removed_id) != NULL
+            || dag_get_vertex_count(d) != REMOVE_N) {
+        fprintf(stderr, "ERROR: test_remove - vertex not removed\n");
+    }
+    for (int i = 0; i < REMOVE_N; i++) {
+        if (dag_find_edge(d, v[i], v[3]) || dag_find_edge(d, v[3], v[i])) {
+            fprintf(stderr, "ERROR: test_remove - edge of removed vertex\n");
+            break;
+        }
+    }
+
+    int n;
+    struct Vertex **order = dag_topological_order(d, &n);
+    struct TopoLevels *levels = dag_topological_levels(d, 2);
+    if (n != REMOVE_N - 1 || levels->n_ids != REMOVE_N - 1) {
+        fprintf(stderr, "ERROR: test_remove - tombstone ordered\n");
+    }
+    for (int i = 0; i < n; i++) {
+        if (order[i] == v[3]) {
+            fprintf(stderr, "ERROR: test_remove - tombstone ordered\n");
+        }
+    }
+    dag_topological_levels_destroy(levels);
+
+    // New vertices get new ids, and the tombstone stays dead.
+    struct Vertex *x = dag_add_vertex(d, &w);
+    if (dag_v_get_id(x) != REMOVE_N || dag_get_vertex(d, removed_id) != NULL
+            || dag_add_edge(d, x, v[0], &w) != 0
+            || dag_add_edge(d, v[REMOVE_N - 1], x, &w) != -1
+            || dag_add_edge(d, x, v[3], &w) != -1
+            || dag_remove_vertex(d, v[3], false) != -1) {
+        fprintf(stderr, "ERROR: test_remove - tombstone reused\n");
+    }
+
+    // Compaction frees the tombstone and closes up the ids after it, and
+    // every edge can still be found.
+    int n_map;
+    int *map = dag_compact(d, &n_map);
+    bool ok = map != NULL && n_map == REMOVE_N + 1 && map[removed_id] == -1
+              && map[REMOVE_N] == REMOVE_N - 1
+              && dag_get_vertex_count(d) == REMOVE_N
+              && dag_v_get_id(x) == REMOVE_N - 1;
+    for (int i = 0; ok && i < REMOVE_N; i++) {
+        if (i == removed_id) continue;
+        ok = map[i] == (i < removed_id ? i : i - 1)
+             && dag_v_get_id(v[i]) == map[i]
+             && dag_get_vertex(d, map[i]) == v[i];
+    }
+    mismatches = 0;
+    for (int i = 0; ok && i < REMOVE_N; i++) {
+        for (int j = 0; j < REMOVE_N; j++) {
+            if (i == removed_id || j == removed_id) continue;
+            mismatches += (dag_find_edge(d, v[i], v[j]) != NULL)
+                          != present[i][j];
+        }
+    }
+    order = dag_topological_order(d, &n);
+    for (int i = 0; ok && i < n; i++) {
+        for (int j = 0; ok && j < dag_v_get_out_degree(order[i]); j++) {
+            struct Vertex *s = dag_v_get_successor(order[i], j);
+            ok = dag_v_get_topo_rank(order[i]) < dag_v_get_topo_rank(s)
+                 && dag_v_get_topo_rank(s) < REMOVE_N;
+        }
+    }
+    if (!ok || mismatches != 0 || n != REMOVE_N
+            || dag_find_edge(d, x, v[0]) == NULL || dag_is_connected(d, x, v[REMOVE_N - 1]) != 1
+            || dag_add_edge(d, v[REMOVE_N - 1], x, &w) != -1) {
+        fprintf(stderr, "ERROR: test_remove - wrong compaction\n");
+    }
+    free(map);
+
+    dag_destroy(d, false);
+
+    // Sweeps clear the entries of every id, removed vertices included.
+    d = dag_create(add_ints, int_compare);
+    int vw[] = {1, 2, 3, 4, 5, 6};
+    struct Vertex *u[6];
+    for (int i = 0; i < 6; i++) {
+        u[i] = dag_add_vertex(d, &vw[i]);
+    }
+    dag_add_edge(d, u[4], u[5], &w);
+    dag_remove_vertex(d, u[1], false);
+    dag_remove_vertex(d, u[2], false);
+    void *dist[6];
+    struct Edge *pred[6];
+    for (int i = 0; i < 6; i++) {
+        dist[i] = &w;
+        pred[i] = (struct Edge *) &w;
+    }
+    if (dag_longest_paths_from(d, u[4], get_int, get_int, dist, pred) != 0
+            || dist[1] != NULL || dist[2] != NULL || pred[2] != NULL
+            || dist[5] == NULL || *(int *) dist[5] != 12) {
+        fprintf(stderr, "ERROR: test_remove - sweep after removal\n");
+    }
+    for (int i = 0; i < 6; i++) {
+        if (dist[i] != &w) free(dist[i]);
+    }
+    dag_destroy(d, false);
+
+    // Removal frees what it owns when asked to.
+    d = dag_create(NULL, NULL);
+    struct Vertex *a = dag_add_vertex(d, malloc(sizeof(int)));
+    struct Vertex *b = dag_add_vertex(d, malloc(sizeof(int)));
+    dag_add_edge(d, a, b, malloc(sizeof(int)));
+    dag_add_edge(d, a, b, malloc(sizeof(int)));
+    dag_remove_edge(d, a, b, true);
+    dag_remove_vertex(d, b, true);
+    dag_destroy(d, true);
+}
+
+#define REDUCE_N 200
+
+void test_transitive_reduction(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+    int w = 1;
+    struct Vertex *v[REDUCE_N];
+    for (int i = 0; i < REDUCE_N; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+
+    // A -> B -> C with A -> C, a parallel edge, and random forward edges.
+    dag_add_edge(d, v[0], v[1], &w);
+    dag_add_edge(d, v[1], v[2], &w);
+    dag_add_edge(d, v[0], v[2], &w);
+    dag_add_edge(d, v[1], v[2], &w);
+    unsigned int seed = 12345;
+    for (int k = 0; k < 4 * REDUCE_N; k++) {
+        seed = seed * 1103515245 + 12345;
+        int a = (seed >> 8) % REDUCE_N;
+        seed = seed * 1103515245 + 12345;
+        int b = (seed >> 8) % REDUCE_N;
+        if (a < b) {
+            dag_add_edge(d, v[a], v[b], &w);
+        }
+    }
+
+    // Check the result against searches from the other successors.
+    int n;
+    struct Edge **redundant = dag_transitive_reduction(d, &n);
+    int expected = 0;
+    int wrong = 0;
+    for (int i = 0; i < REDUCE_N; i++) {
+        for (int j = 0; j < dag_v_get_out_degree(v[i]); j++) {
+            struct Edge *e = dag_v_get_out_edge(v[i], j);
+            struct Vertex *b = dag_e_get_to(e);
+            bool is_redundant = dag_find_edge(d, v[i], b) != e;
+            for (int k = 0; k < dag_v_get_out_degree(v[i]); k++) {
+                struct Vertex *c = dag_v_get_successor(v[i], k);
+                is_redundant |= c != b && dag_is_connected(d, c, b) == 1;
+            }
+            bool listed = false;
+            for (int k = 0; k < n; k++) {
+                listed |= redundant[k] == e;
+            }
+            expected += is_redundant;
+            wrong += is_redundant != listed;
+        }
+    }
+    if (n != expected || wrong != 0 || expected < 2) {
+        fprintf(stderr, "ERROR: test_transitive_reduction - %d of %d edges "
+                "wrong\n", wrong, n);
+    }
+    free(redundant);
+
+    bool reach[REDUCE_N][REDUCE_N];
+    for (int i = 0; i < REDUCE_N; i++) {
+        for (int j = 0; j < REDUCE_N; j++) {
+            reach[i][j] = dag_is_connected(d, v[i], v[j]) == 1;
+        }
+    }
+    int removed = dag_transitive_reduce(d, false);
+    redundant = dag_transitive_reduction(d, &n);
+    if (removed != expected || dag_find_edge(d, v[0], v[2]) != NULL
+            || redundant == NULL || n != 0) {
+        fprintf(stderr, "ERROR: test_transitive_reduction - not reduced\n");
+    }
+    free(redundant);
+    for (int i = 0; i < REDUCE_N; i++) {
+        for (int j = 0; j < REDUCE_N; j++) {
+            if (reach[i][j] != (dag_is_connected(d, v[i], v[j]) == 1)) {
+                fprintf(stderr, "ERROR: test_transitive_reduction - "
+                        "reachability changed\n");
+                i = j = REDUCE_N;
+            }
+        }
+    }
+
+    dag_destroy(d, false);
+}
+
+#define CLOSURE_N 300
+#define CLOSURE_TILE 100
+
+static bool closure_bit(const uint64_t *bits, int i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+void test_closure(void) {
+    struct Dag *d = dag_create(NULL, NULL);
+    int w = 1;
+    struct Vertex *v[CLOSURE_N];
+    for (int i = 0; i < CLOSURE_N; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    // Random edges, each from the higher to the lower id half of the time,
+    // so that the topological order differs from the ids.
+    unsigned int seed = 777;
+    for (int k = 0; k < 2 * CLOSURE_N; k++) {
+        seed = seed * 1103515245 + 12345;
+        int a = (seed >> 8) % CLOSURE_N;
+        seed = seed * 1103515245 + 12345;
+        int b = (seed >> 8) % CLOSURE_N;
+        dag_add_edge(d, v[a], v[b], &w);
+    }
+
+    struct DagClosure *c = dag_closure_build(d, 0, CLOSURE_N, true);
+    int wrong = 0;
+    for (int i = 0; i < CLOSURE_N; i++) {
+        const uint64_t *desc = dag_descendants(c, v[i]);
+        const uint64_t *anc = dag_ancestors(c, v[i]);
+        for (int j = 0; j < CLOSURE_N; j++) {
+            bool reach = i != j && dag_is_connected(d, v[i], v[j]) == 1;
+            bool reached = i != j && dag_is_connected(d, v[j], v[i]) == 1;
+            wrong += closure_bit(desc, j) != reach;
+            wrong += closure_bit(anc, j) != reached;
+            wrong += dag_closure_reaches(c, v[i], v[j]) != reach;
+        }
+    }
+    if (wrong != 0 || dag_closure_memory(c) < 2 * CLOSURE_N * CLOSURE_N / 8) {
+        fprintf(stderr, "ERROR: test_closure - %d wrong bits\n", wrong);
+    }
+    dag_closure_destroy(c);
+
+    // Tiles of the targets give the same answers.
+    for (int first = 0; first < CLOSURE_N; first += CLOSURE_TILE) {
+        c = dag_closure_build(d, first, CLOSURE_TILE, false);
+        int n;
+        dag_closure_range(c, NULL, &n);
+        for (int i = 0; i < CLOSURE_N; i++) {
+            const uint64_t *desc = dag_descendants(c, v[i]);
+            for (int j = 0; j < CLOSURE_N; j++) {
+                bool in_tile = j >= first && j < first + CLOSURE_TILE;
+                int expected = !in_tile ? -1 
+                             : i != j && dag_is_connected(d, v[i], v[j]) == 1;
+                wrong += dag_closure_reaches(c, v[i], v[j]) != expected;
+                wrong += in_tile && closure_bit(desc, j - first) != expected;
+            }
+        }
+        if (wrong != 0 || n != CLOSURE_TILE || dag_ancestors(c, v[0])) {
+            fprintf(stderr, "ERROR: test_closure - tile at %d wrong\n", 
+                    first);
+        }
+        dag_closure_destroy(c);
+    }
+
+    c = dag_closure_build(d, 0, CLOSURE_N, false);
+    dag_add_vertex(d, &w);
+    if (dag_closure_reaches(c, v[0], v[1]) != -1 
+            || dag_descendants(c, v[0]) != NULL
+            || dag_closure_build(d, 1, CLOSURE_N + 1, false) != NULL) {
+        fprintf(stderr, "ERROR: test_closure - stale closure used\n");
+    }
+    dag_closure_destroy(c);
+
+    dag_destroy(d, false);
+}
+
+#define CHURN_N 100
+
+void test_arena_churn(void) {
+    // Freed blocks are handed out again, large ones to smaller requests too.
+    struct Arena *a = arena_create(0);
+    void *small = arena_alloc(a, 24);
+    void *large = arena_alloc(a, 5000);
+    arena_free(a, small, 24);
+    arena_free(a, large, 5000);
+    if (arena_alloc(a, 20) != small || arena_alloc(a, 3000) != large
+            || arena_alloc(a, 20) == small) {
+        fprintf(stderr, "ERROR: test_arena_churn - block not reused\n");
+    }
+    arena_destroy(a);
+
+    // Removing and adding back a hub vertex over and over, compacting the
+    // graph each time, reuses its edges and adjacency arrays and the vertex
+    // itself, so the arena stops growing.
+    struct Dag *d = dag_create_with_alloc(add_ints, int_compare, ALLOC_ARENA);
+    int w = 1;
+    struct Vertex *v[CHURN_N];
+    for (int i = 0; i < CHURN_N; i++) {
+        v[i] = dag_add_vertex(d, &w);
+    }
+    struct DagStats stats;
+    uint64_t bytes = 0;
+    int wrong = 0;
+    for (int round = 0; round < 1000; round++) {
+        for (int i = 1; i < CHURN_N; i++) {
+            wrong += dag_add_edge(d, v[0], v[i], &w) != 0;
+            wrong += i > 1 && dag_add_edge(d, v[i - 1], v[i], &w) != 0;
+        }
+        wrong += dag_is_connected(d, v[1], v[CHURN_N - 1]) != 1;
+        wrong += dag_remove_vertex(d, v[0], false) != 0;
+        for (int i = 2; i < CHURN_N; i++) {
+            wrong += dag_remove_edge(d, v[i - 1], v[i], false) != 0;
+        }
+        v[0] = dag_add_vertex(d, &w);
+        int n_map;
+        int *map = dag_compact(d, &n_map);
+        wrong += map == NULL || dag_v_get_id(v[0]) != CHURN_N - 1;
+        free(map);
+
+        if (dag_stats_get(d, &stats) == 0) {
+            if (round == 10) {
+                bytes = stats.bytes_live;
+            } else if (round > 10 && stats.bytes_live > bytes) {
+                fprintf(stderr, "ERROR: test_arena_churn - arena grew to "
+                        "%lu bytes in round %d\n", 
+                        (unsigned long) stats.bytes_live, round);
+                break;
+            }
+        }
+    }
+    if (wrong != 0 || dag_v_get_out_degree(v[1]) != 0) {
+        fprintf(stderr, "ERROR: test_arena_churn - %d failed operations\n",
+                wrong);
+    }
+    dag_destroy(d, false);
+}
@@ -0,0 +1,325 @@
+#ifndef DAG_TYPED_H
+#define DAG_TYPED_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "dag.h"
+
+/*
+ * Type specialised DAGs with weights stored inline in the vertices and
+ * edges. Unlike the generic API no weight is ever boxed behind a void *, and
+ * the add and compare operations are expanded inline, so queries do not
+ * allocate once the graph has been built.
+ *
+ * DAG_DEFINE(name, vw_t, ew_t, add_op, cmp_op) defines `struct name` and the
+ * functions name_create(), name_destroy(), name_add_vertex(),
+ * name_add_edge(), name_find_edge(), name_is_connected(),
+ * name_longest_path(), name_v_get_weight() and name_e_get_weight().
+ * Vertices and edges are identified by their int ids, numbered from 0 in the
+ * order they were added. The functions returning an int return -1 when given
+ * a vertex id that is out of range.
+ *
+ * vw_t - type of the vertex weights, also used for path weights.
+ * ew_t - type of the edge weights.
+ * add_op(x, y) - adds a vw_t and a vw_t or ew_t, giving a vw_t.
+ * cmp_op(x, y) - compares two vw_t, giving an enum WeightComp.
+ *
+ * The dag_i64 and dag_f64 graphs for int64_t and double weights are defined
+ * below.
+ */
+
+#define DAG_ADD_NUM(x, y) ((x) + (y))
+#define DAG_CMP_NUM(x, y) \
+    ((x) > (y) ? GREATER_THAN : (x) < (y) ? LESS_THAN : EQUAL)
+
+#define DAG_DEFINE(name, vw_t, ew_t, add_op, cmp_op)                           \
+struct name##_edge {                                                           \
+    int from;                                                                  \
+    int to;                                                                    \
+    ew_t weight;                                                               \
+};                                                                             \
+                                                                               \
+struct name##_adj {                                                            \
+    int *edges;                                                                \
+    int size;                                                                  \
+    int cap;                                                                   \
+};                                                                             \
+                                                                               \
+struct name {                                                                  \
+    vw_t *v_weight;                                                            \
+    struct name##_adj *out;                                                    \
+    int v_size;                                                                \
+    int v_cap;                                                                 \
+    struct name##_edge *edges;                                                 \
+    int e_size;                                                                \
+    int e_cap;                                                                 \
+    /* Scratch space for searches, sized with the vertex arrays. */            \
+    unsigned int *mark;                                                        \
+    unsigned int epoch;                                                        \
+    int *stack;                                                                \
+    int *next;                                                                 \
+    int *order;                                                                \
+    int *pred;                                                                 \
+    vw_t *best;                                                                \
+};                                                                             \
+                                                                               \
+static inline struct name *name##_create(void) {                               \
+    return calloc(1, sizeof(struct name));                                     \
+}                                                                              \
+                                                                               \
+static inline void name##_destroy(struct name *g) {                            \
+    for (int i = 0; i < g->v_size; i++) {                                      \
+        free(g->out[i].edges);                                                 \
+    }                                                                          \
+    free(g->v_weight);                                                         \
+    free(g->out);                                                              \
+    free(g->edges);                                                            \
+    free(g->mark);                                                             \
+    free(g->stack);                                                            \
+    free(g->next);                                                             \
+    free(g->order);                                                            \
+    free(g->pred);                                                             \
+    free(g->best);                                                             \
+    free(g);                                                                   \
+}                                                                              \
+                                                                               \
+static inline vw_t name##_v_get_weight(struct name *g, int v) {                \
+    return g->v_weight[v];                                                     \
+}                                                                              \
+                                                                               \
+static inline ew_t name##_e_get_weight(struct name *g, int e) {                \
+    return g->edges[e].weight;                                                 \
+}                                                                              \
+                                                                               \
+/* Grows every per-vertex array to hold at least one more vertex. */           \
+static inline int name##_grow_(struct name *g) {                               \
+    int cap = g->v_cap == 0 ? 16 : g->v_cap * 2;                               \
+    void *p;                                                                   \
+                                                                               \
+    p = realloc(g->v_weight, cap * sizeof(*g->v_weight));                      \
+    if (p == NULL) return -1;                                                  \
+    g->v_weight = p;                                                           \
+    p = realloc(g->out, cap * sizeof(*g->out));                                \
+    if (p == NULL) return -1;                                                  \
+    g->out = p;                                                                \
+    p = realloc(g->mark, cap * sizeof(*g->mark));                              \
+    if (p == NULL) return -1;                                                  \
+    g->mark = p;                                                               \
+    p = realloc(g->stack, cap * sizeof(*g->stack));                            \
+    if (p == NULL) return -1;                                                  \
+    g->stack = p;                                                              \
+    p = realloc(g->next, cap * sizeof(*g->next));                              \
+    if (p == NULL) return -1;                                                  \
+    g->next = p;                                                               \
+    p = realloc(g->order, cap * sizeof(*g->order));                            \
+    if (p == NULL) return -1;                                                  \
+    g->order = p;                                                              \
+    p = realloc(g->pred, cap * sizeof(*g->pred));                              \
+    if (p == NULL) return -1;                                                  \
+    g->pred = p;                                                               \
+    p = realloc(g->best, cap * sizeof(*g->best));                              \
+    if (p == NULL) return -1;                                                  \
+    g->best = p;                                                               \
+                                                                               \
+    g->v_cap = cap;                                                            \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+/* Adds a vertex with weight w; returns its id, or -1 on failure. */           \
+static inline int name##_add_vertex(struct name *g, vw_t w) {                  \
+    if (g->v_size == g->v_cap && name##_grow_(g) < 0) {                        \
+        return -1;                                                             \
+    }                                                                          \
+                                                                               \
+    int v = g->v_size++;                                                       \
+    g->v_weight[v] = w;                                                        \
+    g->out[v].edges = NULL;                                                    \
+    g->out[v].size = 0;                                                        \
+    g->out[v].cap = 0;                                                         \
+    g->mark[v] = 0;                                                            \
+                                                                               \
+    return v;                                                                  \
+}                                                                              \
+                                                                               \
+/* Checks that v is the id of a vertex. */                                     \
+static inline int name##_has_vertex_(struct name *g, int v) {                  \
+    return v >= 0 && v < g->v_size;                                            \
+}                                                                              \
+                                                                               \
+/* Starts a new search in which no vertex is marked. */                        \
+static inline void name##_next_epoch_(struct name *g) {                        \
+    if (++g->epoch == 0) {                                                     \
+        memset(g->mark, 0, g->v_size * sizeof(*g->mark));                      \
+        g->epoch = 1;                                                          \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+/* Returns 1 if b can be reached from a, 0 if not, or -1 if a or b is not a    \
+   vertex. */                                                                  \
+static inline int name##_is_connected(struct name *g, int a, int b) {          \
+    if (!name##_has_vertex_(g, a) || !name##_has_vertex_(g, b)) return -1;     \
+    if (a == b) return 1;                                                      \
+                                                                               \
+    name##_next_epoch_(g);                                                     \
+                                                                               \
+    int top = 0;                                                               \
+    g->stack[top++] = a;                                                       \
+    g->mark[a] = g->epoch;                                                     \
+                                                                               \
+    while (top > 0) {                                                          \
+        struct name##_adj *adj = &g->out[g->stack[--top]];                     \
+                                                                               \
+        for (int i = 0; i < adj->size; i++) {                                  \
+            int w = g->edges[adj->edges[i]].to;                                \
+            if (w == b) return 1;                                              \
+            if (g->mark[w] != g->epoch) {                                      \
+                g->mark[w] = g->epoch;                                         \
+                g->stack[top++] = w;                                           \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+/* Returns the index of an edge from a to b, or -1 if there is none. */        \
+static inline int name##_find_edge(struct name *g, int a, int b) {             \
+    if (!name##_has_vertex_(g, a)) return -1;                                  \
+                                                                               \
+    struct name##_adj *adj = &g->out[a];                                       \
+                                                                               \
+    for (int i = 0; i < adj->size; i++) {                                      \
+        if (g->edges[adj->edges[i]].to == b) return adj->edges[i];             \
+    }                                                                          \
+                                                                               \
+    return -1;                                                                 \
+}                                                                              \
+                                                                               \
+/* Adds an edge from a to b with weight w; returns 0, or -1 if a or b is not   \
+   a vertex, the edge would create a cycle or memory could not be              \
+   allocated. */                                                               \
+static inline int name##_add_edge(struct name *g, int a, int b, ew_t w) {      \
+    if (!name##_has_vertex_(g, a) || !name##_has_vertex_(g, b)) return -1;     \
+    if (name##_is_connected(g, b, a)) {                                        \
+        return -1;                                                             \
+    }                                                                          \
+                                                                               \
+    if (g->e_size == g->e_cap) {                                               \
+        int cap = g->e_cap == 0 ? 16 : g->e_cap * 2;                           \
+        void *p = realloc(g->edges, cap * sizeof(*g->edges));                  \
+        if (p == NULL) return -1;                                              \
+        g->edges = p;                                                          \
+        g->e_cap = cap;                                                        \
+    }                                                                          \
+                                                                               \
+    struct name##_adj *adj = &g->out[a];                                       \
+    if (adj->size == adj->cap) {                                               \
+        int cap = adj->cap == 0 ? 4 : adj->cap * 2;                            \
+        void *p = realloc(adj->edges, cap * sizeof(*adj->edges));              \
+        if (p == NULL) return -1;                                              \
+        adj->edges = p;                                                        \
+        adj->cap = cap;                                                        \
+    }                                                                          \
+                                                                               \
+    int e = g->e_size++;                                                       \
+    g->edges[e].from = a;                                                      \
+    g->edges[e].to = b;                                                        \
+    g->edges[e].weight = w;                                                    \
+    adj->edges[adj->size++] = e;                                               \
+                                                                               \
+    return 0;                                                                  \
+}                                                                              \
+                                                                               \
+/* Writes the vertices reachable from a to g->order in topological order,      \
+   and returns how many there are. */                                          \
+static inline int name##_order_from_(struct name *g, int a) {                  \
+    name##_next_epoch_(g);                                                     \
+                                                                               \
+    int top = 0;                                                               \
+    int count = 0;                                                             \
+    g->stack[top++] = a;                                                       \
+    g->next[a] = 0;                                                            \
+    g->mark[a] = g->epoch;                                                     \
+                                                                               \
+    while (top > 0) {                                                          \
+        int v = g->stack[top - 1];                                             \
+                                                                               \
+        if (g->next[v] < g->out[v].size) {                                     \
+            int w = g->edges[g->out[v].edges[g->next[v]++]].to;                \
+            if (g->mark[w] != g->epoch) {                                      \
+                g->mark[w] = g->epoch;                                         \
+                g->next[w] = 0;                                                \
+                g->stack[top++] = w;                                           \
+            }                                                                  \
+        } else {                                                               \
+            g->order[g->v_size - 1 - count++] = v;                             \
+            top--;                                                             \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    memmove(g->order, g->order + g->v_size - count, count * sizeof(int));      \
+    return count;                                                              \
+}                                                                              \
+                                                                               \
+/* Computes the weight of the longest path from a to b, summing vertex and     \
+   edge weights. If path is not NULL it receives the vertices of the path      \
+   and path_len their number; path must have room for every vertex.            \
+   Returns 0 on success, or -1 if b can not be reached from a or a or b is     \
+   not a vertex. */                                                            \
+static inline int name##_longest_path(struct name *g, int a, int b,            \
+                                      vw_t *weight, int *path, int *path_len) {\
+    if (!name##_has_vertex_(g, a) || !name##_has_vertex_(g, b)) return -1;     \
+                                                                               \
+    int n = name##_order_from_(g, a);                                          \
+                                                                               \
+    /* Vertices marked in this epoch have a value in best. */                  \
+    name##_next_epoch_(g);                                                     \
+    g->best[a] = g->v_weight[a];                                               \
+    g->mark[a] = g->epoch;                                                     \
+    g->pred[a] = -1;                                                           \
+                                                                               \
+    for (int i = 0; i < n && g->order[i] != b; i++) {                          \
+        int u = g->order[i];                                                   \
+        struct name##_adj *adj = &g->out[u];                                   \
+                                                                               \
+        for (int j = 0; j < adj->size; j++) {                                  \
+            struct name##_edge *e = &g->edges[adj->edges[j]];                  \
+            vw_t cand = add_op(add_op(g->best[u], e->weight),                  \
+                               g->v_weight[e->to]);                            \
+                                                                               \
+            if (g->mark[e->to] != g->epoch                                     \
+                    || cmp_op(cand, g->best[e->to]) == GREATER_THAN) {         \
+                g->mark[e->to] = g->epoch;                                     \
+                g->best[e->to] = cand;                                         \
+                g->pred[e->to] = u;                                            \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+                                                                               \
+    if (g->mark[b] != g->epoch) {                                              \
+        return -1;                                                             \
+    }                                                                          \
+                                                                               \
+    *weight = g->best[b];                                                      \
+                                                                               \
+    if (path) {                                                                \
+        int len = 0;                                                           \
+        for (int v = b; v != -1; v = g->pred[v]) {                             \
+            len++;                                                             \
+        }                                                                      \
+        int i = len;                                                           \
+        for (int v = b; v != -1; v = g->pred[v]) {                             \
+            path[--i] = v;                                                     \
+        }                                                                      \
+        *path_len = len;                                                       \
+    }                                                                          \
+                                                                               \
+    return 0;                                                                  \
+}
+
+DAG_DEFINE(dag_i64, int64_t, int64_t, DAG_ADD_NUM, DAG_CMP_NUM)
+DAG_DEFINE(dag_f64, double, double, DAG_ADD_NUM, DAG_CMP_NUM)
+
+#endif
@@ -3,9 +3,6 @@
 #include <stdbool.h>
 
 #include "queue.h"
-#include "list.h"
-
-struct node;
 
 struct Queue *queue_create(void) {
     struct Queue *q = malloc(sizeof(*q));
@@ -13,31 +10,52 @@ struct Queue *queue_create(void) {
         return NULL;
     }
 
-    q->first = NULL;
-    q->last = NULL;
+    q->items = NULL;
+    q->head = 0;
+    q->size = 0;
+    q->cap = 0;
 
     return q;
 }
 
+/**
+ * doubles the capacity of the buffer, moving the elements to its start.
+ * returns - 0 on success; -1 on failure.
+ */
+static int queue_grow(struct Queue *q) {
+    int new_cap = q->cap == 0 ? 16 : q->cap * 2;
+    void **items = malloc(new_cap * sizeof(*items));
+    if (items == NULL) {
+        return -1;
+    }
+
+    for (int i = 0; i < q->size; i++) {
+        items[i] = q->items[(q->head + i) % q->cap];
+    }
+
+    free(q->items);
+    q->items = items;
+    q->head = 0;
+    q->cap = new_cap;
+
+    return 0;
+}
+
 /**
  * adds an element to the end of the queue.
  * returns - 0 on success; -1 on failure.
  */
 int queue_enqueue(struct Queue *q, void *e) {
-    struct node *n = malloc(sizeof(*n));
-    if (n == NULL) { 
+    if (q->size == q->cap && queue_grow(q) < 0) {
         return -1;
     }
 
-    n->next = NULL;
-    n->value = e;
-    if (q->first == NULL || q->last == NULL) {
-        q->first = n;
-        q->last = n;
-    } else {
-        q->last->next = n;
-        q->last = n;
+    int tail = q->head + q->size;
+    if (tail >= q->cap) {
+        tail -= q->cap;
     }
+    q->items[tail] = e;
+    q->size++;
 
     return 0;
 }
@@ -45,39 +63,40 @@ int queue_enqueue(struct Queue *q, void *e) {
 /**
  * removes an element from the beginning of the queue 
  */
-struct node *queue_dequeue(struct Queue *q) {
-    struct node *n = q->first;
-
-    if (q->first)
-        q->first = q->first->next;
-        
-    if (q->first == NULL)
-        q->last = NULL;
-    
-    return n;
+void *queue_dequeue(struct Queue *q) {
+    if (q->size == 0) {
+        return NULL;
+    }
+
+    void *e = q->items[q->head];
+    q->head++;
+    if (q->head == q->cap) {
+        q->head = 0;
+    }
+    q->size--;
+
+    return e;
 }
 
 /**
  * retrieves the element first in the queue
  */
-struct node *queue_peek(struct Queue *q) {
-    return q->first;
+void *queue_peek(struct Queue *q) {
+    return q->size == 0 ? NULL : q->items[q->head];
 }
 
 bool queue_is_empty(struct Queue *q) {
-    return q->first == NULL;
+    return q->size == 0;
 }
 
-int queue_destroy(struct Queue *q) {
-    node *n = queue_dequeue(q);
-
-    while (n != NULL) {
-        free(n);
-
-        n = queue_dequeue(q);
-    }
+void queue_reset(struct Queue *q) {
+    q->head = 0;
+    q->size = 0;
+}
 
+int queue_destroy(struct Queue *q) {
+    free(q->items);
     free(q);
 
     return 0;
-}
\ No newline at end of file
+}
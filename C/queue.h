@@ -1,33 +1,46 @@
 #ifndef QUEUE_H
 #define QUEUE_H
 
+#include <stdbool.h>
 
-
+/*
+ * A queue stored in a growable circular buffer. Enqueueing only allocates
+ * when the buffer is full, and the buffer is kept between uses.
+ */
 struct Queue {
-    struct node *first;
-    struct node *last;
+    void **items;
+    int head;
+    int size;
+    int cap;
 };
 
 struct Queue *queue_create(void);
 
 /**
  * adds an element to the end of the queue.
+ * returns - 0 on success; -1 on failure.
  */
 int queue_enqueue(struct Queue *q, void *e);
 
 /**
  * removes an element from the beginning of the queue 
- * returns - the node that was dequeued.
+ * returns - the element that was dequeued; NULL if the queue is empty.
  */
-struct node *queue_dequeue(struct Queue *q);
+void *queue_dequeue(struct Queue *q);
 
 /**
  * retrieves the element first in the queue
+ * returns - the first element; NULL if the queue is empty.
  */
-struct node *queue_peek(struct Queue *q);
+void *queue_peek(struct Queue *q);
 
 bool queue_is_empty(struct Queue *q);
 
+/**
+ * removes all elements from the queue, keeping its buffer for reuse.
+ */
+void queue_reset(struct Queue *q);
+
 int queue_destroy(struct Queue *q);
 
-#endif
\ No newline at end of file
+#endif